@@ -0,0 +1,298 @@
+#include "polyline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//  . :
+//   lab1_bench [  ] [  JSON]
+//    3, 10, 100, ..., 10^7   JSON  stdout.
+//     ns/op (    
+// ), raw_ns_per_op, points/s  allocations/op. ,  
+//   ,   
+
+//      operator new
+static std::atomic<std::uint64_t> allocationCount{0};
+
+void* operator new(std::size_t bytes) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(bytes ? bytes : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+//      
+volatile double valueSink = 0.0;
+const void* volatile pointerSink = nullptr;
+
+template<typename V>
+void keep(const V& value) {
+    if constexpr (std::is_arithmetic_v<V>) {
+        valueSink = static_cast<double>(value);
+    }
+    else {
+        pointerSink = value.begin();
+        if (!value.empty()) valueSink = static_cast<double>(value.end()[-1].x);
+    }
+}
+
+struct Result {
+    std::string name{};
+    std::string type{};
+    size_t points = 0;
+    std::uint64_t iterations = 0;
+    double nsPerOp = 0.0;
+    double rawNsPerOp = 0.0;
+    double pointsPerSecond = 0.0;
+    double allocationsPerOp = 0.0;
+    bool skipped = false; //   
+};
+
+constexpr double minSeconds = 0.2; //     
+constexpr double minBatchSeconds = 1e-3; //     
+
+double baselineNs = 0.0; //     
+
+//    /proc/meminfo (MemAvailable); 0,  .
+//  overcommit  Linux      bad_alloc,  
+//  ,     
+std::uint64_t availableMemory() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        std::uint64_t kilobytes = 0;
+        if (fields >> key >> kilobytes && key == "MemAvailable:") return kilobytes * 1024;
+    }
+    return 0;
+}
+
+//     count   T (   )
+template<typename T>
+bool fits(size_t count, size_t copies) {
+    std::uint64_t available = availableMemory();
+    return available == 0 || static_cast<std::uint64_t>(count) * copies * sizeof(Point<T>) < available / 2;
+}
+
+Result skippedResult(const std::string& name, const std::string& type, size_t points) {
+    Result result;
+    result.name = name;
+    result.type = type;
+    result.points = points;
+    result.skipped = true;
+    std::cerr << type << ' ' << name << ' ' << points << " skipped\n";
+    return result;
+}
+
+//  op ,     .  ,
+//    minBatchSeconds;  ,    
+//  minSeconds.  ns/op  baselineNs
+template<typename Op>
+Result measure(const std::string& name, const std::string& type, size_t points, Op op) {
+    Result result;
+    result.name = name;
+    result.type = type;
+    result.points = points;
+    try {
+        op(); // 
+        std::uint64_t batch = 1;
+        std::uint64_t iterations = 0;
+        std::uint64_t allocations = allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        auto batchStart = start;
+        double elapsed = 0.0;
+        do {
+            for (std::uint64_t i = 0; i < batch; ++i) {
+                op();
+            }
+            iterations += batch;
+            auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - batchStart).count() < minBatchSeconds) batch *= 2;
+            batchStart = now;
+            elapsed = std::chrono::duration<double>(now - start).count();
+        } while (elapsed < minSeconds);
+        allocations = allocationCount.load(std::memory_order_relaxed) - allocations;
+
+        result.iterations = iterations;
+        result.rawNsPerOp = elapsed * 1e9 / static_cast<double>(iterations);
+        result.nsPerOp = std::max(result.rawNsPerOp - baselineNs, 0.0);
+        result.pointsPerSecond = result.nsPerOp > 0.0 ? static_cast<double>(points) * 1e9 / result.nsPerOp : 0.0;
+        result.allocationsPerOp = static_cast<double>(allocations) / static_cast<double>(iterations);
+    }
+    catch (const std::bad_alloc&) {
+        result.skipped = true;
+    }
+    std::cerr << type << ' ' << name << ' ' << points << (result.skipped ? " skipped" : "") << '\n';
+    return result;
+}
+
+template<typename T>
+void benchmarkType(const std::string& type, const std::vector<size_t>& sizes, std::vector<Result>& results) {
+    using P = Polyline<T>;
+    const Point<T> point(T(1), T(2));
+
+    results.push_back(measure("ctor_point", type, 1, [&] {
+        P polyline(point);
+        keep(polyline);
+    }));
+
+    for (size_t n : sizes) {
+        // ,     -     n 
+        if (!fits<T>(n, 6)) {
+            results.push_back(skippedResult("all", type, n));
+            continue;
+        }
+        results.push_back(measure("ctor_size", type, n, [&] {
+            P polyline(n);
+            keep(polyline);
+        }));
+        results.push_back(measure("ctor_uninitialized", type, n, [&] {
+            P polyline(n, uninitialized);
+            keep(polyline);
+        }));
+        results.push_back(measure("ctor_random", type, n, [&] {
+            P polyline(n, T(0), T(1));
+            keep(polyline);
+        }));
+        results.push_back(measure("ctor_seed", type, n, [&] {
+            P polyline(n, T(0), T(1), std::uint64_t(42));
+            keep(polyline);
+        }));
+        results.push_back(measure("ctor_seed_parallel", type, n, [&] {
+            P polyline(n, T(0), T(1), std::uint64_t(42), parallel);
+            keep(polyline);
+        }));
+
+        try {
+            P a(n, T(0), T(1), std::uint64_t(1));
+            P b(a);
+
+            results.push_back(measure("ctor_copy", type, n, [&] {
+                P copy(a);
+                keep(copy);
+            }));
+            results.push_back(measure("ctor_move", type, n, [&] {
+                P copy(a);
+                P moved(std::move(copy));
+                keep(moved);
+            }));
+            results.push_back(measure("length_fast", type, n, [&] {
+                double length = a.length();
+                keep(length);
+            }));
+            results.push_back(measure("length_precise", type, n, [&] {
+                double length = a.length(LengthMode::Precise);
+                keep(length);
+            }));
+            results.push_back(measure("length_parallel", type, n, [&] {
+                double length = a.length(parallel);
+                keep(length);
+            }));
+            results.push_back(measure("operator_plus_polyline", type, 2 * n, [&] {
+                P sum = a + b;
+                keep(sum);
+            }));
+            results.push_back(measure("operator_plus_rvalue_polyline", type, 2 * n, [&] {
+                P sum = P(a) + b;
+                keep(sum);
+            }));
+            results.push_back(measure("operator_plus_point", type, n + 1, [&] {
+                P sum = a + point;
+                keep(sum);
+            }));
+            results.push_back(measure("operator_plus_rvalue_point", type, n + 1, [&] {
+                P sum = P(a) + point;
+                keep(sum);
+            }));
+            results.push_back(measure("operator_plus_point_polyline", type, n + 1, [&] {
+                P sum = point + a;
+                keep(sum);
+            }));
+            //  :    
+            results.push_back(measure("operator_equal", type, n, [&] {
+                bool equal = a == b;
+                keep(equal);
+            }));
+        }
+        catch (const std::bad_alloc&) {
+            std::cerr << type << " inputs of " << n << " points skipped\n";
+        }
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results) {
+    out << "{\n  \"baseline_ns_per_op\": " << baselineNs << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"type\": \"" << r.type << "\", \"points\": " << r.points;
+        if (r.skipped) {
+            out << ", \"skipped\": true}";
+        }
+        else {
+            out << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp << ", \"raw_ns_per_op\": " << r.rawNsPerOp
+                << ", \"points_per_second\": " << r.pointsPerSecond << ", \"allocations_per_op\": " << r.allocationsPerOp << "}";
+        }
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        size_t maxPoints = 10000000;
+        if (argc > 1) maxPoints = static_cast<size_t>(std::stoull(argv[1]));
+
+        std::vector<size_t> sizes;
+        sizes.push_back(3);
+        for (size_t n = 10; n <= maxPoints; n *= 10) {
+            sizes.push_back(n);
+        }
+
+        //    ,   
+        baselineNs = measure("empty", "none", 0, [] {}).rawNsPerOp;
+
+        std::vector<Result> results;
+        results.push_back(measure("create_isosceles_triangle", "double", 3, [] {
+            Polyline<double> triangle = createIsoscelesTriangle(60.0, 2.0);
+            keep(triangle);
+        }));
+        benchmarkType<float>("float", sizes, results);
+        benchmarkType<double>("double", sizes, results);
+
+        std::ostringstream json;
+        json.precision(10);
+        writeJson(json, results);
+        if (argc > 2) {
+            std::ofstream file(argv[2]);
+            file << json.str();
+            if (!file) throw std::runtime_error(std::string("Cannot write file: ") + argv[2]);
+        }
+        else {
+            std::cout << json.str();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
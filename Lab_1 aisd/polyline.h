@@ -0,0 +1,4910 @@
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+#include <complex>
+#include <random>
+#include <utility>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <span>
+#include <numeric>
+#include <limits>
+#include <cstdint>
+#include <iterator>
+#include <concepts>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <exception>
+#include <chrono>
+#include <typeinfo>
+#include <memory_resource>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <charconv>
+#include <cctype>
+#include <istream>
+#include <ostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define POLYLINE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define POLYLINE_TARGET_AVX2
+#else
+#define POLYLINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#else
+#define POLYLINE_X86 0
+#endif
+
+template<typename T>
+struct Point {
+    T x, y;
+
+    constexpr Point(T x = 0, T y = 0) : x(x), y(y) {}
+};
+
+//    
+enum class LengthMode {
+    Fast,   // sqrt(dx*dx + dy*dy)  
+    Precise // std::hypot:        
+};
+
+//   ,    : p.length(parallel)
+struct ParallelTag {};
+constexpr ParallelTag parallel{};
+
+//     : Polyline<T> p(n, uninitialized).
+//       
+struct UninitializedTag {};
+constexpr UninitializedTag uninitialized{};
+
+//  task(0) ... task(tasks - 1)   .  
+//    ;      .
+//          
+//       
+template<typename Task>
+void parallelFor(size_t tasks, Task task) {
+    if (tasks == 0) return;
+    size_t hardware = std::thread::hardware_concurrency();
+    size_t threads = std::min(std::max<size_t>(hardware, 1), tasks);
+
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    std::atomic<bool> failed{false};
+    auto work = [&](size_t thread) {
+        try {
+            for (size_t i = thread; i < tasks && !failed.load(std::memory_order_relaxed); i += threads) {
+                task(i);
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) failure = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    try {
+        for (size_t t = 1; t < threads; ++t) {
+            pool.emplace_back(work, t);
+        }
+    }
+    catch (...) {
+        failed.store(true, std::memory_order_relaxed);
+        for (std::thread& worker : pool) worker.join();
+        throw;
+    }
+    work(0);
+    for (std::thread& worker : pool) worker.join();
+    if (failure) std::rethrow_exception(failure);
+}
+
+//  :     , 
+//  .  minParallel  - std::sort
+template<typename It, typename Less>
+void parallelSort(It first, It last, Less less, size_t minParallel) {
+    size_t count = static_cast<size_t>(last - first);
+    size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    if (count < minParallel || hardware == 1) {
+        std::sort(first, last, less);
+        return;
+    }
+    size_t blocks = hardware;
+    auto border = [&](size_t block) {
+        return first + static_cast<std::ptrdiff_t>(count * block / blocks);
+    };
+    parallelFor(blocks, [&](size_t block) {
+        std::sort(border(block), border(block + 1), less);
+    });
+    for (size_t width = 1; width < blocks; width *= 2) {
+        size_t pairs = (blocks + 2 * width - 1) / (2 * width);
+        parallelFor(pairs, [&](size_t pair) {
+            size_t left = pair * 2 * width;
+            size_t middle = std::min(left + width, blocks);
+            size_t right = std::min(left + 2 * width, blocks);
+            if (middle < right) std::inplace_merge(border(left), border(middle), border(right), less);
+        });
+    }
+}
+
+//   Philox4x32-10 (Salmon et al., Random123).
+//    32-        ,
+//       ,
+//      ,     
+namespace philox {
+
+constexpr size_t batch = 8; //   ;    
+
+// out[w][lane] -  w    firstCounter + lane
+template<size_t Lanes>
+void generate(std::uint64_t firstCounter, std::uint64_t key, std::uint32_t out[4][Lanes]) {
+    std::uint32_t c0[Lanes], c1[Lanes], c2[Lanes], c3[Lanes];
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        std::uint64_t counter = firstCounter + lane;
+        c0[lane] = static_cast<std::uint32_t>(counter);
+        c1[lane] = static_cast<std::uint32_t>(counter >> 32);
+        c2[lane] = 0;
+        c3[lane] = 0;
+    }
+    std::uint32_t k0 = static_cast<std::uint32_t>(key);
+    std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            std::uint64_t p0 = std::uint64_t(0xD2511F53u) * c0[lane];
+            std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * c2[lane];
+            std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1[lane] ^ k0;
+            std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3[lane] ^ k1;
+            c1[lane] = static_cast<std::uint32_t>(p1);
+            c3[lane] = static_cast<std::uint32_t>(p0);
+            c0[lane] = n0;
+            c2[lane] = n2;
+        }
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        out[0][lane] = c0[lane];
+        out[1][lane] = c1[lane];
+        out[2][lane] = c2[lane];
+        out[3][lane] = c3[lane];
+    }
+}
+
+//   [0, 1)   : 53   double, 24  float
+inline double toUnit(std::uint32_t hi, std::uint32_t lo, double) {
+    std::uint64_t bits = (std::uint64_t(hi) << 32 | lo) >> 11;
+    return static_cast<double>(bits) * 0x1.0p-53;
+}
+
+inline float toUnit(std::uint32_t word, float) {
+    return static_cast<float>(word >> 8) * 0x1.0p-24f;
+}
+
+//     :   double,   float
+template<typename T>
+constexpr size_t coordsPerBlock = std::is_same_v<T, float> ? 4 : 2;
+
+//   coords[first, last)    [m1, m2).
+//  j     j / coordsPerBlock<T>
+template<typename T>
+void fillUniform(T* coords, size_t first, size_t last, T m1, T m2, std::uint64_t seed) {
+    static_assert(std::is_same_v<T, double> || std::is_same_v<T, float>, "Only float and double coordinates are supported");
+    constexpr size_t perBlock = coordsPerBlock<T>;
+    constexpr size_t perBatch = perBlock * batch;
+    std::uint32_t words[4][batch];
+    T range = m2 - m1;
+    size_t j = first - first % perBatch;
+    for (; j < last; j += perBatch) {
+        generate<batch>(j / perBlock, seed, words);
+        T values[perBatch];
+        for (size_t lane = 0; lane < batch; ++lane) {
+            if constexpr (std::is_same_v<T, float>) {
+                for (size_t w = 0; w < 4; ++w) {
+                    values[lane * 4 + w] = m1 + range * toUnit(words[w][lane], T());
+                }
+            }
+            else {
+                values[lane * 2] = m1 + range * toUnit(words[0][lane], words[1][lane], T());
+                values[lane * 2 + 1] = m1 + range * toUnit(words[2][lane], words[3][lane], T());
+            }
+        }
+        size_t begin = std::max(j, first);
+        size_t end = std::min(j + perBatch, last);
+        for (size_t k = begin; k < end; ++k) {
+            coords[k] = values[k - j];
+        }
+    }
+}
+
+//     2^16 
+template<typename T>
+void fillUniformParallel(T* coords, size_t count, T m1, T m2, std::uint64_t seed) {
+    constexpr size_t chunk = size_t(1) << 16;
+    size_t chunks = (count + chunk - 1) / chunk;
+    parallelFor(chunks, [&](size_t c) {
+        fillUniform(coords, c * chunk, std::min(count, (c + 1) * chunk), m1, m2, seed);
+    });
+}
+
+//  index   ,   fillUniform  
+template<typename T>
+Point<T> uniformPoint(size_t index, T m1, T m2, std::uint64_t seed) {
+    constexpr size_t perBlock = coordsPerBlock<T>;
+    std::uint32_t words[4][1];
+    generate<1>(2 * index / perBlock, seed, words);
+    T range = m2 - m1;
+    if constexpr (std::is_same_v<T, float>) {
+        size_t w = 2 * index % perBlock;
+        return Point<T>(m1 + range * toUnit(words[w][0], T()), m1 + range * toUnit(words[w + 1][0], T()));
+    }
+    else {
+        return Point<T>(m1 + range * toUnit(words[0][0], words[1][0], T()),
+                        m1 + range * toUnit(words[2][0], words[3][0], T()));
+    }
+}
+
+} // namespace philox
+
+//    .    float  double
+//   :  (x0, y0, x1, y1, ...)   (x[], y[]).
+//          CPUID.
+namespace lengthKernels {
+
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+inline SimdLevel detectSimdLevel() {
+#if POLYLINE_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    //     YMM   
+    if (osxsave && avx && avx2 && fma && (_xgetbv(0) & 0x6) == 0x6) return SimdLevel::Avx2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::Avx2;
+#endif
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+inline SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+//  ,      
+template<typename T>
+double interleavedScalar(const T* xy, size_t begin, size_t count) {
+    double total = 0.0;
+    for (size_t i = begin + 1; i < count; ++i) {
+        double dx = static_cast<double>(xy[2 * i] - xy[2 * i - 2]);
+        double dy = static_cast<double>(xy[2 * i + 1] - xy[2 * i - 1]);
+        total += std::sqrt(dx * dx + dy * dy);
+    }
+    return total;
+}
+
+template<typename T>
+double splitScalar(const T* xs, const T* ys, size_t begin, size_t count) {
+    double total = 0.0;
+    for (size_t i = begin + 1; i < count; ++i) {
+        double dx = static_cast<double>(xs[i] - xs[i - 1]);
+        double dy = static_cast<double>(ys[i] - ys[i - 1]);
+        total += std::sqrt(dx * dx + dy * dy);
+    }
+    return total;
+}
+
+#if POLYLINE_X86
+
+inline double horizontalSum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+inline double interleavedSse2(const double* xy, size_t count) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 1;
+    for (; i + 2 <= count; i += 2) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(xy + 2 * i), _mm_loadu_pd(xy + 2 * i - 2));
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(xy + 2 * i + 2), _mm_loadu_pd(xy + 2 * i));
+        d0 = _mm_mul_pd(d0, d0);
+        d1 = _mm_mul_pd(d1, d1);
+        __m128d sq = _mm_add_pd(_mm_unpacklo_pd(d0, d1), _mm_unpackhi_pd(d0, d1));
+        acc = _mm_add_pd(acc, _mm_sqrt_pd(sq));
+    }
+    return horizontalSum(acc) + interleavedScalar(xy, i - 1, count);
+}
+
+inline double interleavedSse2(const float* xy, size_t count) {
+    __m128d accLo = _mm_setzero_pd();
+    __m128d accHi = _mm_setzero_pd();
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(xy + 2 * i), _mm_loadu_ps(xy + 2 * i - 2));
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(xy + 2 * i + 4), _mm_loadu_ps(xy + 2 * i + 2));
+        d0 = _mm_mul_ps(d0, d0);
+        d1 = _mm_mul_ps(d1, d1);
+        __m128 sq = _mm_add_ps(_mm_shuffle_ps(d0, d1, _MM_SHUFFLE(2, 0, 2, 0)),
+                               _mm_shuffle_ps(d0, d1, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128 len = _mm_sqrt_ps(sq);
+        //   double,       
+        accLo = _mm_add_pd(accLo, _mm_cvtps_pd(len));
+        accHi = _mm_add_pd(accHi, _mm_cvtps_pd(_mm_movehl_ps(len, len)));
+    }
+    return horizontalSum(_mm_add_pd(accLo, accHi)) + interleavedScalar(xy, i - 1, count);
+}
+
+inline double splitSse2(const double* xs, const double* ys, size_t count) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 1;
+    for (; i + 2 <= count; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i), _mm_loadu_pd(xs + i - 1));
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i), _mm_loadu_pd(ys + i - 1));
+        __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        acc = _mm_add_pd(acc, _mm_sqrt_pd(sq));
+    }
+    return horizontalSum(acc) + splitScalar(xs, ys, i - 1, count);
+}
+
+inline double splitSse2(const float* xs, const float* ys, size_t count) {
+    __m128d accLo = _mm_setzero_pd();
+    __m128d accHi = _mm_setzero_pd();
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), _mm_loadu_ps(xs + i - 1));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), _mm_loadu_ps(ys + i - 1));
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        accLo = _mm_add_pd(accLo, _mm_cvtps_pd(len));
+        accHi = _mm_add_pd(accHi, _mm_cvtps_pd(_mm_movehl_ps(len, len)));
+    }
+    return horizontalSum(_mm_add_pd(accLo, accHi)) + splitScalar(xs, ys, i - 1, count);
+}
+
+POLYLINE_TARGET_AVX2 inline double horizontalSum(__m256d v) {
+    return horizontalSum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+POLYLINE_TARGET_AVX2 inline double interleavedAvx2(const double* xy, size_t count) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        //       (dx, dy)
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(xy + 2 * i), _mm256_loadu_pd(xy + 2 * i - 2));
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(xy + 2 * i + 4), _mm256_loadu_pd(xy + 2 * i + 2));
+        __m256d sq = _mm256_hadd_pd(_mm256_mul_pd(d0, d0), _mm256_mul_pd(d1, d1));
+        acc = _mm256_add_pd(acc, _mm256_sqrt_pd(sq));
+    }
+    return horizontalSum(acc) + interleavedScalar(xy, i - 1, count);
+}
+
+POLYLINE_TARGET_AVX2 inline double interleavedAvx2(const float* xy, size_t count) {
+    __m256d accLo = _mm256_setzero_pd();
+    __m256d accHi = _mm256_setzero_pd();
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(xy + 2 * i), _mm256_loadu_ps(xy + 2 * i - 2));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(xy + 2 * i + 8), _mm256_loadu_ps(xy + 2 * i + 6));
+        __m256 dx = _mm256_shuffle_ps(d0, d1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 dy = _mm256_shuffle_ps(d0, d1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)));
+        accLo = _mm256_add_pd(accLo, _mm256_cvtps_pd(_mm256_castps256_ps128(len)));
+        accHi = _mm256_add_pd(accHi, _mm256_cvtps_pd(_mm256_extractf128_ps(len, 1)));
+    }
+    return horizontalSum(_mm256_add_pd(accLo, accHi)) + interleavedScalar(xy, i - 1, count);
+}
+
+POLYLINE_TARGET_AVX2 inline double splitAvx2(const double* xs, const double* ys, size_t count) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), _mm256_loadu_pd(xs + i - 1));
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), _mm256_loadu_pd(ys + i - 1));
+        acc = _mm256_add_pd(acc, _mm256_sqrt_pd(_mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy))));
+    }
+    return horizontalSum(acc) + splitScalar(xs, ys, i - 1, count);
+}
+
+POLYLINE_TARGET_AVX2 inline double splitAvx2(const float* xs, const float* ys, size_t count) {
+    __m256d accLo = _mm256_setzero_pd();
+    __m256d accHi = _mm256_setzero_pd();
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), _mm256_loadu_ps(xs + i - 1));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), _mm256_loadu_ps(ys + i - 1));
+        __m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)));
+        accLo = _mm256_add_pd(accLo, _mm256_cvtps_pd(_mm256_castps256_ps128(len)));
+        accHi = _mm256_add_pd(accHi, _mm256_cvtps_pd(_mm256_extractf128_ps(len, 1)));
+    }
+    return horizontalSum(_mm256_add_pd(accLo, accHi)) + splitScalar(xs, ys, i - 1, count);
+}
+
+#endif // POLYLINE_X86
+
+//    count ,      xy
+template<typename T>
+double interleaved(const T* xy, size_t count) {
+#if POLYLINE_X86
+    switch (simdLevel()) {
+    case SimdLevel::Avx2: return interleavedAvx2(xy, count);
+    case SimdLevel::Sse2: return interleavedSse2(xy, count);
+    default: break;
+    }
+#endif
+    return interleavedScalar(xy, 0, count);
+}
+
+//    count     
+template<typename T>
+double split(const T* xs, const T* ys, size_t count) {
+#if POLYLINE_X86
+    switch (simdLevel()) {
+    case SimdLevel::Avx2: return splitAvx2(xs, ys, count);
+    case SimdLevel::Sse2: return splitSse2(xs, ys, count);
+    default: break;
+    }
+#endif
+    return splitScalar(xs, ys, 0, count);
+}
+
+
+//   .     
+// ,     .  
+//     ,  
+//     .    :  AVX2 
+// FMA,       SSE2   
+constexpr size_t parallelChunkSize = size_t(1) << 16; //   
+
+inline double pairwiseSum(const double* values, size_t count) {
+    if (count == 0) return 0.0;
+    if (count == 1) return values[0];
+    size_t half = count / 2;
+    return pairwiseSum(values, half) + pairwiseSum(values + half, count - half);
+}
+
+// chunkLength(first, count)      [first, first + count)
+template<typename ChunkLength>
+double parallelLength(size_t count, ChunkLength chunkLength) {
+    if (count < 2) return 0.0;
+    size_t segments = count - 1;
+    size_t chunks = (segments + parallelChunkSize - 1) / parallelChunkSize;
+    std::vector<double> sums(chunks);
+    parallelFor(chunks, [&](size_t chunk) {
+        size_t first = chunk * parallelChunkSize;
+        size_t last = std::min(first + parallelChunkSize, segments);
+        sums[chunk] = chunkLength(first, last - first + 1);
+    });
+    return pairwiseSum(sums.data(), chunks);
+}
+
+} // namespace lengthKernels
+
+//       epsilon  
+//    .  float   float 
+//   epsilon  double,    operator==
+namespace equalityKernels {
+
+template<typename T>
+bool nearlyEqualScalar(const T* a, const T* b, size_t begin, size_t count, double epsilon) {
+    for (size_t i = begin; i < count; ++i) {
+        if (std::abs(a[i] - b[i]) > epsilon) return false;
+    }
+    return true;
+}
+
+#if POLYLINE_X86
+
+inline bool nearlyEqualSse2(const double* a, const double* b, size_t count, double epsilon) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d eps = _mm_set1_pd(epsilon);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d d0 = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        __m128d d1 = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        __m128d differ = _mm_or_pd(_mm_cmpgt_pd(d0, eps), _mm_cmpgt_pd(d1, eps));
+        if (_mm_movemask_pd(differ) != 0) return false;
+    }
+    return nearlyEqualScalar(a, b, i, count, epsilon);
+}
+
+inline bool nearlyEqualSse2(const float* a, const float* b, size_t count, double epsilon) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128d eps = _mm_set1_pd(epsilon);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        __m128d differ = _mm_or_pd(_mm_cmpgt_pd(_mm_cvtps_pd(d), eps),
+                                   _mm_cmpgt_pd(_mm_cvtps_pd(_mm_movehl_ps(d, d)), eps));
+        if (_mm_movemask_pd(differ) != 0) return false;
+    }
+    return nearlyEqualScalar(a, b, i, count, epsilon);
+}
+
+POLYLINE_TARGET_AVX2 inline bool nearlyEqualAvx2(const double* a, const double* b, size_t count, double epsilon) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d eps = _mm256_set1_pd(epsilon);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d d0 = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        __m256d d1 = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        __m256d differ = _mm256_or_pd(_mm256_cmp_pd(d0, eps, _CMP_GT_OQ), _mm256_cmp_pd(d1, eps, _CMP_GT_OQ));
+        if (_mm256_movemask_pd(differ) != 0) return false;
+    }
+    return nearlyEqualScalar(a, b, i, count, epsilon);
+}
+
+POLYLINE_TARGET_AVX2 inline bool nearlyEqualAvx2(const float* a, const float* b, size_t count, double epsilon) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256d eps = _mm256_set1_pd(epsilon);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(d));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1));
+        __m256d differ = _mm256_or_pd(_mm256_cmp_pd(lo, eps, _CMP_GT_OQ), _mm256_cmp_pd(hi, eps, _CMP_GT_OQ));
+        if (_mm256_movemask_pd(differ) != 0) return false;
+    }
+    return nearlyEqualScalar(a, b, i, count, epsilon);
+}
+
+#endif
+
+// true,  |a[i] - b[i]| <= epsilon   count 
+template<typename T>
+bool nearlyEqual(const T* a, const T* b, size_t count, double epsilon) {
+#if POLYLINE_X86
+    switch (lengthKernels::simdLevel()) {
+    case lengthKernels::SimdLevel::Avx2: return nearlyEqualAvx2(a, b, count, epsilon);
+    case lengthKernels::SimdLevel::Sse2: return nearlyEqualSse2(a, b, count, epsilon);
+    default: break;
+    }
+#endif
+    return nearlyEqualScalar(a, b, 0, count, epsilon);
+}
+
+} // namespace equalityKernels
+
+//   :
+// x' = a * x + b * y + tx
+// y' = c * x + d * y + ty
+template<typename T>
+struct Affine2 {
+    T a = 1, b = 0, c = 0, d = 1;
+    T tx = 0, ty = 0;
+
+    static Affine2 identity() {
+        return Affine2();
+    }
+
+    static Affine2 translation(T dx, T dy) {
+        return Affine2{ 1, 0, 0, 1, dx, dy };
+    }
+
+    //   angle       
+    static Affine2 rotation(double angle) {
+        T cosine = static_cast<T>(std::cos(angle));
+        T sine = static_cast<T>(std::sin(angle));
+        return Affine2{ cosine, -sine, sine, cosine, 0, 0 };
+    }
+
+    //    center
+    static Affine2 rotation(double angle, const Point<T>& center) {
+        return translation(center.x, center.y) * rotation(angle) * translation(-center.x, -center.y);
+    }
+
+    static Affine2 scaling(T sx, T sy) {
+        return Affine2{ sx, 0, 0, sy, 0, 0 };
+    }
+
+    // : (m1 * m2)(p) = m1(m2(p))
+    Affine2 operator*(const Affine2& m) const {
+        return Affine2{ a * m.a + b * m.c, a * m.b + b * m.d,
+                        c * m.a + d * m.c, c * m.b + d * m.d,
+                        a * m.tx + b * m.ty + tx, c * m.tx + d * m.ty + ty };
+    }
+
+    Point<T> operator()(const Point<T>& p) const {
+        return Point<T>(a * p.x + b * p.y + tx, c * p.x + d * p.y + ty);
+    }
+};
+
+//     count   
+//  xy; in  out  .  (x, y) 
+//  (a, d),  (y, x) -  (b, c),   (tx, ty)
+namespace affineKernels {
+
+template<typename T>
+void transformScalar(const T* in, T* out, size_t begin, size_t count, const Affine2<T>& m) {
+    for (size_t i = begin; i < count; ++i) {
+        T x = in[2 * i];
+        T y = in[2 * i + 1];
+        out[2 * i] = m.a * x + m.b * y + m.tx;
+        out[2 * i + 1] = m.c * x + m.d * y + m.ty;
+    }
+}
+
+#if POLYLINE_X86
+
+inline void transformSse2(const double* in, double* out, size_t count, const Affine2<double>& m) {
+    const __m128d diagonal = _mm_setr_pd(m.a, m.d);
+    const __m128d cross = _mm_setr_pd(m.b, m.c);
+    const __m128d shift = _mm_setr_pd(m.tx, m.ty);
+    for (size_t i = 0; i < count; ++i) {
+        __m128d v = _mm_loadu_pd(in + 2 * i);
+        __m128d swapped = _mm_shuffle_pd(v, v, 1);
+        _mm_storeu_pd(out + 2 * i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(v, diagonal), _mm_mul_pd(swapped, cross)), shift));
+    }
+}
+
+inline void transformSse2(const float* in, float* out, size_t count, const Affine2<float>& m) {
+    const __m128 diagonal = _mm_setr_ps(m.a, m.d, m.a, m.d);
+    const __m128 cross = _mm_setr_ps(m.b, m.c, m.b, m.c);
+    const __m128 shift = _mm_setr_ps(m.tx, m.ty, m.tx, m.ty);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_loadu_ps(in + 2 * i);
+        __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(out + 2 * i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(v, diagonal), _mm_mul_ps(swapped, cross)), shift));
+    }
+    transformScalar(in, out, i, count, m);
+}
+
+POLYLINE_TARGET_AVX2 inline void transformAvx2(const double* in, double* out, size_t count, const Affine2<double>& m) {
+    const __m256d diagonal = _mm256_setr_pd(m.a, m.d, m.a, m.d);
+    const __m256d cross = _mm256_setr_pd(m.b, m.c, m.b, m.c);
+    const __m256d shift = _mm256_setr_pd(m.tx, m.ty, m.tx, m.ty);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256d v = _mm256_loadu_pd(in + 2 * i);
+        __m256d swapped = _mm256_permute_pd(v, 0x5);
+        _mm256_storeu_pd(out + 2 * i, _mm256_fmadd_pd(v, diagonal, _mm256_fmadd_pd(swapped, cross, shift)));
+    }
+    transformScalar(in, out, i, count, m);
+}
+
+POLYLINE_TARGET_AVX2 inline void transformAvx2(const float* in, float* out, size_t count, const Affine2<float>& m) {
+    const __m256 diagonal = _mm256_setr_ps(m.a, m.d, m.a, m.d, m.a, m.d, m.a, m.d);
+    const __m256 cross = _mm256_setr_ps(m.b, m.c, m.b, m.c, m.b, m.c, m.b, m.c);
+    const __m256 shift = _mm256_setr_ps(m.tx, m.ty, m.tx, m.ty, m.tx, m.ty, m.tx, m.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 v = _mm256_loadu_ps(in + 2 * i);
+        __m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm256_storeu_ps(out + 2 * i, _mm256_fmadd_ps(v, diagonal, _mm256_fmadd_ps(swapped, cross, shift)));
+    }
+    transformScalar(in, out, i, count, m);
+}
+
+#endif
+
+template<typename T>
+void transform(const T* in, T* out, size_t count, const Affine2<T>& m) {
+#if POLYLINE_X86
+    switch (lengthKernels::simdLevel()) {
+    case lengthKernels::SimdLevel::Avx2: transformAvx2(in, out, count, m); return;
+    case lengthKernels::SimdLevel::Sse2: transformSse2(in, out, count, m); return;
+    default: break;
+    }
+#endif
+    transformScalar(in, out, 0, count, m);
+}
+
+//        parallelChunkSize 
+template<typename T>
+void transformParallel(const T* in, T* out, size_t count, const Affine2<T>& m) {
+    size_t chunk = lengthKernels::parallelChunkSize;
+    parallelFor((count + chunk - 1) / chunk, [&](size_t block) {
+        size_t first = block * chunk;
+        transform(in + 2 * first, out + 2 * first, std::min(chunk, count - first), m);
+    });
+}
+
+} // namespace affineKernels
+
+//    ,  .
+//    min > max
+template<typename T>
+struct Bounds {
+    Point<T> min{ std::numeric_limits<T>::max(), std::numeric_limits<T>::max() };
+    Point<T> max{ std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() };
+
+    bool empty() const {
+        return min.x > max.x;
+    }
+
+    void expand(const Point<T>& p) {
+        if (p.x < min.x) min.x = p.x;
+        if (p.x > max.x) max.x = p.x;
+        if (p.y < min.y) min.y = p.y;
+        if (p.y > max.y) max.y = p.y;
+    }
+
+    void expand(const Bounds& b) {
+        if (b.empty()) return;
+        expand(b.min);
+        expand(b.max);
+    }
+
+    bool contains(const Point<T>& p) const {
+        return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+    }
+
+    bool intersects(const Bounds& b) const {
+        return !empty() && !b.empty() && min.x <= b.max.x && b.min.x <= max.x && min.y <= b.max.y && b.min.y <= max.y;
+    }
+};
+
+//   count    .
+//  NaN 
+namespace boundsKernels {
+
+template<typename T>
+void interleavedScalar(const T* xy, size_t begin, size_t count, Bounds<T>& result) {
+    for (size_t i = begin; i < count; ++i) {
+        result.expand(Point<T>(xy[2 * i], xy[2 * i + 1]));
+    }
+}
+
+#if POLYLINE_X86
+
+//   (x, y, x, y, ...):   - ,  - .
+// min(v, acc)  acc,   v  NaN
+
+//  lanes     
+template<typename T>
+void mergeLanes(const T* lows, const T* highs, int lanes, Bounds<T>& result) {
+    for (int k = 0; k < lanes; k += 2) {
+        result.min.x = std::min(result.min.x, lows[k]);
+        result.min.y = std::min(result.min.y, lows[k + 1]);
+        result.max.x = std::max(result.max.x, highs[k]);
+        result.max.y = std::max(result.max.y, highs[k + 1]);
+    }
+}
+inline Bounds<double> interleavedSse2(const double* xy, size_t count) {
+    __m128d low = _mm_set1_pd(std::numeric_limits<double>::max());
+    __m128d high = _mm_set1_pd(std::numeric_limits<double>::lowest());
+    for (size_t i = 0; i < count; ++i) {
+        __m128d v = _mm_loadu_pd(xy + 2 * i);
+        low = _mm_min_pd(v, low);
+        high = _mm_max_pd(v, high);
+    }
+    alignas(16) double lows[2];
+    alignas(16) double highs[2];
+    _mm_store_pd(lows, low);
+    _mm_store_pd(highs, high);
+    Bounds<double> result;
+    mergeLanes(lows, highs, 2, result);
+    return result;
+}
+
+inline Bounds<float> interleavedSse2(const float* xy, size_t count) {
+    __m128 low = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 high = _mm_set1_ps(std::numeric_limits<float>::lowest());
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_loadu_ps(xy + 2 * i);
+        low = _mm_min_ps(v, low);
+        high = _mm_max_ps(v, high);
+    }
+    alignas(16) float lows[4];
+    alignas(16) float highs[4];
+    _mm_store_ps(lows, low);
+    _mm_store_ps(highs, high);
+    Bounds<float> result;
+    mergeLanes(lows, highs, 4, result);
+    interleavedScalar(xy, i, count, result);
+    return result;
+}
+
+POLYLINE_TARGET_AVX2 inline Bounds<double> interleavedAvx2(const double* xy, size_t count) {
+    __m256d low = _mm256_set1_pd(std::numeric_limits<double>::max());
+    __m256d high = _mm256_set1_pd(std::numeric_limits<double>::lowest());
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256d v = _mm256_loadu_pd(xy + 2 * i);
+        low = _mm256_min_pd(v, low);
+        high = _mm256_max_pd(v, high);
+    }
+    alignas(32) double lows[4];
+    alignas(32) double highs[4];
+    _mm256_store_pd(lows, low);
+    _mm256_store_pd(highs, high);
+    Bounds<double> result;
+    mergeLanes(lows, highs, 4, result);
+    interleavedScalar(xy, i, count, result);
+    return result;
+}
+
+POLYLINE_TARGET_AVX2 inline Bounds<float> interleavedAvx2(const float* xy, size_t count) {
+    __m256 low = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 high = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 v = _mm256_loadu_ps(xy + 2 * i);
+        low = _mm256_min_ps(v, low);
+        high = _mm256_max_ps(v, high);
+    }
+    alignas(32) float lows[8];
+    alignas(32) float highs[8];
+    _mm256_store_ps(lows, low);
+    _mm256_store_ps(highs, high);
+    Bounds<float> result;
+    mergeLanes(lows, highs, 8, result);
+    interleavedScalar(xy, i, count, result);
+    return result;
+}
+
+#endif
+
+template<typename T>
+Bounds<T> interleaved(const T* xy, size_t count) {
+#if POLYLINE_X86
+    switch (lengthKernels::simdLevel()) {
+    case lengthKernels::SimdLevel::Avx2: return interleavedAvx2(xy, count);
+    case lengthKernels::SimdLevel::Sse2: return interleavedSse2(xy, count);
+    default: break;
+    }
+#endif
+    Bounds<T> result;
+    interleavedScalar(xy, 0, count, result);
+    return result;
+}
+
+} // namespace boundsKernels
+
+//    : first -   (p[first], p[first + 1])
+//  , second -  (      )
+template<typename T>
+struct Intersection {
+    size_t first = 0;
+    size_t second = 0;
+    Point<T> point{}; //  ;    -    
+};
+
+//       x:   
+//   ,      , 
+//     .   -   
+//   double
+namespace sweepKernels {
+
+template<typename T>
+struct Segment {
+    T minX, maxX, minY, maxY;
+    size_t index;
+    int source; // 0  1 -  
+};
+
+inline double orientation(const Point<double>& a, const Point<double>& b, const Point<double>& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// c   ab  ,      
+inline bool onSegment(const Point<double>& a, const Point<double>& b, const Point<double>& c) {
+    return std::min(a.x, b.x) <= c.x && c.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= c.y && c.y <= std::max(a.y, b.y);
+}
+
+//    ab  cd;     at
+inline bool intersect(const Point<double>& a, const Point<double>& b, const Point<double>& c, const Point<double>& d, Point<double>& at) {
+    double d1 = orientation(c, d, a);
+    double d2 = orientation(c, d, b);
+    double d3 = orientation(a, b, c);
+    double d4 = orientation(a, b, d);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        double t = d1 / (d1 - d2);
+        at = Point<double>(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y));
+        return true;
+    }
+    if (d1 == 0 && onSegment(c, d, a)) { at = a; return true; }
+    if (d2 == 0 && onSegment(c, d, b)) { at = b; return true; }
+    if (d3 == 0 && onSegment(a, b, c)) { at = c; return true; }
+    if (d4 == 0 && onSegment(a, b, d)) { at = d; return true; }
+    return false;
+}
+
+template<typename T>
+Point<double> widen(const Point<T>& p) {
+    return Point<double>(static_cast<double>(p.x), static_cast<double>(p.y));
+}
+
+//  ,    clip
+template<typename T>
+void collect(std::span<const Point<T>> points, int source, const Bounds<T>& clip, std::vector<Segment<T>>& out) {
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        const Point<T>& a = points[i];
+        const Point<T>& b = points[i + 1];
+        Segment<T> segment{ std::min(a.x, b.x), std::max(a.x, b.x), std::min(a.y, b.y), std::max(a.y, b.y), i, source };
+        if (segment.minX <= clip.max.x && clip.min.x <= segment.maxX && segment.minY <= clip.max.y && clip.min.y <= segment.maxY) {
+            out.push_back(segment);
+        }
+    }
+}
+
+//    minX . report(s, t)  
+//      ,   .
+//       ,  
+// ;    (first, second)
+template<typename T, typename Check>
+std::vector<Intersection<T>> sweep(std::vector<Segment<T>>& segments, Check check, bool inParallel) {
+    auto byLeft = [](const Segment<T>& a, const Segment<T>& b) {
+        return a.minX < b.minX || (a.minX == b.minX && (a.source < b.source || (a.source == b.source && a.index < b.index)));
+    };
+    parallelSort(segments.begin(), segments.end(), byLeft, inParallel ? size_t(0) : static_cast<size_t>(-1));
+
+    constexpr size_t block = 4096;
+    size_t blocks = inParallel ? (segments.size() + block - 1) / block : 1;
+    std::vector<std::vector<Intersection<T>>> found(blocks);
+    auto scan = [&](size_t b) {
+        size_t last = inParallel ? std::min(segments.size(), (b + 1) * block) : segments.size();
+        for (size_t i = inParallel ? b * block : 0; i < last; ++i) {
+            const Segment<T>& s = segments[i];
+            for (size_t j = i + 1; j < segments.size() && segments[j].minX <= s.maxX; ++j) {
+                const Segment<T>& t = segments[j];
+                if (t.minY > s.maxY || s.minY > t.maxY) continue;
+                Intersection<T> hit;
+                if (check(s, t, hit)) found[b].push_back(hit);
+            }
+        }
+    };
+    if (inParallel) {
+        parallelFor(blocks, scan);
+    }
+    else {
+        scan(0);
+    }
+
+    std::vector<Intersection<T>> result;
+    for (auto& part : found) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    std::sort(result.begin(), result.end(), [](const Intersection<T>& a, const Intersection<T>& b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    });
+    return result;
+}
+
+// :   first < second.   (  
+//    )     -  
+//  ,        
+template<typename T>
+std::vector<Intersection<T>> selfIntersections(std::span<const Point<T>> points, bool inParallel) {
+    if (points.size() < 3) return {};
+    size_t last = points.size() - 2; //   
+    bool closed = points.front().x == points.back().x && points.front().y == points.back().y;
+    std::vector<Segment<T>> segments;
+    segments.reserve(points.size() - 1);
+    Bounds<T> everything;
+    everything.min = Point<T>(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest());
+    everything.max = Point<T>(std::numeric_limits<T>::max(), std::numeric_limits<T>::max());
+    collect(points, 0, everything, segments);
+
+    auto check = [&](const Segment<T>& s, const Segment<T>& t, Intersection<T>& hit) {
+        size_t i = std::min(s.index, t.index);
+        size_t j = std::max(s.index, t.index);
+        Point<double> a = widen(points[i]), b = widen(points[i + 1]);
+        Point<double> c = widen(points[j]), d = widen(points[j + 1]);
+        Point<double> at;
+        if (!intersect(a, b, c, d, at)) return false;
+        //    : v - , u  w -   
+        bool next = j == i + 1;
+        bool wrap = closed && i == 0 && j == last && last > 1;
+        if (next || wrap) {
+            Point<double> u = next ? a : b;
+            Point<double> v = next ? b : a;
+            Point<double> w = next ? d : c;
+            bool overlap = orientation(u, v, w) == 0 && (u.x - v.x) * (w.x - v.x) + (u.y - v.y) * (w.y - v.y) > 0;
+            if (!overlap) return false;
+            at = v;
+        }
+        hit.first = i;
+        hit.second = j;
+        hit.point = Point<T>(static_cast<T>(at.x), static_cast<T>(at.y));
+        return true;
+    };
+    return sweep(segments, check, inParallel);
+}
+
+//    .    
+//     
+template<typename T>
+std::vector<Intersection<T>> intersections(std::span<const Point<T>> first, const Bounds<T>& firstBounds,
+                                           std::span<const Point<T>> second, const Bounds<T>& secondBounds, bool inParallel) {
+    if (first.size() < 2 || second.size() < 2 || !firstBounds.intersects(secondBounds)) return {};
+    std::vector<Segment<T>> segments;
+    collect(first, 0, secondBounds, segments);
+    collect(second, 1, firstBounds, segments);
+
+    auto check = [&](const Segment<T>& s, const Segment<T>& t, Intersection<T>& hit) {
+        if (s.source == t.source) return false;
+        const Segment<T>& u = s.source == 0 ? s : t;
+        const Segment<T>& v = s.source == 0 ? t : s;
+        Point<double> at;
+        if (!intersect(widen(first[u.index]), widen(first[u.index + 1]), widen(second[v.index]), widen(second[v.index + 1]), at)) return false;
+        hit.first = u.index;
+        hit.second = v.index;
+        hit.point = Point<T>(static_cast<T>(at.x), static_cast<T>(at.y));
+        return true;
+    };
+    return sweep(segments, check, inParallel);
+}
+
+} // namespace sweepKernels
+
+//    .    
+// POLYLINE_INSTRUMENTATION=1;    count()  ScopedTimer
+//      .      ,
+// snapshot()     ,  
+#ifndef POLYLINE_INSTRUMENTATION
+#define POLYLINE_INSTRUMENTATION 0
+#endif
+
+namespace instrumentation {
+
+constexpr bool enabled = POLYLINE_INSTRUMENTATION != 0;
+
+enum class Counter {
+    Allocations,         //    
+    BytesAllocated,      //  
+    DeepCopies,          //   
+    Growths,             //    
+    PointsCopied,        //    
+    LengthCalls,         //  length()
+    LengthNanoseconds,   //   length()
+    EqualityCalls,       //  operator==
+    EqualityNanoseconds, //   operator==
+    Count
+};
+
+constexpr size_t counterCount = static_cast<size_t>(Counter::Count);
+
+//    writeMetrics
+constexpr const char* counterNames[counterCount] = {
+    "polyline_allocations_total",
+    "polyline_allocated_bytes_total",
+    "polyline_deep_copies_total",
+    "polyline_growths_total",
+    "polyline_points_copied_total",
+    "polyline_length_calls_total",
+    "polyline_length_nanoseconds_total",
+    "polyline_equality_calls_total",
+    "polyline_equality_nanoseconds_total",
+};
+
+//     Polyline
+struct Snapshot {
+    std::string name;
+    std::array<std::uint64_t, counterCount> values{};
+
+    std::uint64_t operator[](Counter counter) const {
+        return values[static_cast<size_t>(counter)];
+    }
+};
+
+class Registry;
+
+//   .   ,   
+//     ;    snapshot()
+class ThreadCounters {
+private:
+    Registry& registry;
+
+public:
+    std::array<std::atomic<std::uint64_t>, counterCount> values{};
+
+    explicit ThreadCounters(Registry& registry);
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+    ~ThreadCounters();
+
+    void add(Counter counter, std::uint64_t amount) {
+        std::atomic<std::uint64_t>& value = values[static_cast<size_t>(counter)];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+inline std::mutex& registriesMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline std::vector<Registry*>& registries() {
+    static std::vector<Registry*> list;
+    return list;
+}
+
+//  :      
+class Registry {
+private:
+    std::string name;
+    std::mutex mutex{};
+    std::vector<ThreadCounters*> threads{};
+    std::array<std::uint64_t, counterCount> retired{};
+
+public:
+    explicit Registry(std::string name) : name(std::move(name)) {
+        std::lock_guard<std::mutex> lock(registriesMutex());
+        registries().push_back(this);
+    }
+
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    ~Registry() {
+        std::lock_guard<std::mutex> lock(registriesMutex());
+        auto& list = registries();
+        list.erase(std::remove(list.begin(), list.end(), this), list.end());
+    }
+
+    void attach(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(counters);
+    }
+
+    //  :      
+    void detach(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < counterCount; ++i) {
+            retired[i] += counters->values[i].load(std::memory_order_relaxed);
+        }
+        threads.erase(std::remove(threads.begin(), threads.end(), counters), threads.end());
+    }
+
+    Snapshot snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Snapshot result{ name, retired };
+        for (const ThreadCounters* counters : threads) {
+            for (size_t i = 0; i < counterCount; ++i) {
+                result.values[i] += counters->values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+};
+
+inline ThreadCounters::ThreadCounters(Registry& registry) : registry(registry) {
+    registry.attach(this);
+}
+
+inline ThreadCounters::~ThreadCounters() {
+    registry.detach(this);
+}
+
+//    : Polyline<double>, Polyline<float, ..., 0>
+template<typename T, typename Allocator, size_t InlineCapacity>
+std::string instanceName() {
+    std::string result = "Polyline<";
+    if constexpr (std::is_same_v<T, double>) result += "double";
+    else if constexpr (std::is_same_v<T, float>) result += "float";
+    else result += typeid(T).name();
+    if (!std::is_same_v<Allocator, std::allocator<Point<T>>> || InlineCapacity != 4) {
+        result += ", ";
+        result += typeid(Allocator).name();
+        result += ", " + std::to_string(InlineCapacity);
+    }
+    return result + ">";
+}
+
+template<typename T, typename Allocator, size_t InlineCapacity>
+Registry& registryFor() {
+    static Registry registry(instanceName<T, Allocator, InlineCapacity>());
+    return registry;
+}
+
+template<typename T, typename Allocator, size_t InlineCapacity>
+ThreadCounters& localCounters() {
+    thread_local ThreadCounters counters(registryFor<T, Allocator, InlineCapacity>());
+    return counters;
+}
+
+template<typename T, typename Allocator, size_t InlineCapacity>
+void count(Counter counter, std::uint64_t amount = 1) {
+    if constexpr (enabled) {
+        localCounters<T, Allocator, InlineCapacity>().add(counter, amount);
+    }
+}
+
+//       
+template<typename T, typename Allocator, size_t InlineCapacity>
+class ScopedTimer {
+private:
+    struct Empty {};
+    using Clock = std::chrono::steady_clock;
+
+    Counter calls;
+    Counter nanoseconds;
+    [[no_unique_address]] std::conditional_t<enabled, Clock::time_point, Empty> start;
+
+public:
+    ScopedTimer(Counter calls, Counter nanoseconds) : calls(calls), nanoseconds(nanoseconds), start() {
+        if constexpr (enabled) start = Clock::now();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        if constexpr (enabled) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            ThreadCounters& counters = localCounters<T, Allocator, InlineCapacity>();
+            counters.add(calls, 1);
+            counters.add(nanoseconds, static_cast<std::uint64_t>(elapsed));
+        }
+    }
+};
+
+//   Polyline<T, Allocator, InlineCapacity>
+template<typename T, typename Allocator = std::allocator<Point<T>>, size_t InlineCapacity = 4>
+Snapshot snapshot() {
+    return registryFor<T, Allocator, InlineCapacity>().snapshot();
+}
+
+//   ,   - 
+inline std::vector<Snapshot> snapshot() {
+    std::lock_guard<std::mutex> lock(registriesMutex());
+    std::vector<Snapshot> result;
+    for (Registry* registry : registries()) {
+        result.push_back(registry->snapshot());
+    }
+    return result;
+}
+
+//     Prometheus
+inline void writeMetrics(std::ostream& out) {
+    std::vector<Snapshot> snapshots = snapshot();
+    for (size_t i = 0; i < counterCount; ++i) {
+        out << "# TYPE " << counterNames[i] << " counter\n";
+        for (const Snapshot& s : snapshots) {
+            out << counterNames[i] << "{instance=\"" << s.name << "\"} " << s.values[i] << '\n';
+        }
+    }
+}
+
+} // namespace instrumentation
+
+//  :      
+//      (release()  ).
+//         .
+//  
+class MonotonicArena {
+private:
+    struct Block {
+        Block* next; //   
+    };
+
+    Block* head = nullptr; //   
+    unsigned char* cursor = nullptr; //      
+    unsigned char* limit = nullptr; //   
+    size_t nextBlockSize; //   ; 
+
+    void addBlock(size_t minBytes) {
+        size_t bytes = std::max(nextBlockSize, minBytes + sizeof(Block) + alignof(std::max_align_t));
+        Block* block = static_cast<Block*>(::operator new(bytes));
+        block->next = head;
+        head = block;
+        cursor = reinterpret_cast<unsigned char*>(block) + sizeof(Block);
+        limit = reinterpret_cast<unsigned char*>(block) + bytes;
+        nextBlockSize = bytes * 2;
+    }
+
+public:
+    explicit MonotonicArena(size_t initialBlockSize = size_t(64) * 1024) : nextBlockSize(initialBlockSize) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() {
+        release();
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        void* result = cursor;
+        size_t space = static_cast<size_t>(limit - cursor);
+        if (cursor == nullptr || std::align(alignment, bytes, result, space) == nullptr) {
+            addBlock(bytes + alignment);
+            result = cursor;
+            space = static_cast<size_t>(limit - cursor);
+            std::align(alignment, bytes, result, space);
+        }
+        cursor = static_cast<unsigned char*>(result) + bytes;
+        return result;
+    }
+
+    //    ;      
+    void release() {
+        while (head != nullptr) {
+            Block* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+        cursor = nullptr;
+        limit = nullptr;
+    }
+};
+
+//   MonotonicArena; deallocate   
+template<typename U>
+class ArenaAllocator {
+private:
+    template<typename> friend class ArenaAllocator;
+
+    MonotonicArena* arena;
+
+public:
+    using value_type = U;
+
+    explicit ArenaAllocator(MonotonicArena& arena) noexcept : arena(&arena) {}
+
+    template<typename V>
+    ArenaAllocator(const ArenaAllocator<V>& other) noexcept : arena(other.arena) {}
+
+    U* allocate(size_t count) {
+        return static_cast<U*>(arena->allocate(count * sizeof(U), alignof(U)));
+    }
+
+    void deallocate(U*, size_t) noexcept {}
+
+    template<typename V>
+    bool operator==(const ArenaAllocator<V>& other) const noexcept {
+        return arena == other.arena;
+    }
+};
+
+template<typename T>
+class PolylineSoA;
+
+//  count     out.
+//      memcpy
+template<typename P>
+P* uninitializedCopyPoints(const P* first, size_t count, P* out) {
+    if constexpr (std::is_trivially_copyable_v<P>) {
+        if (count > 0) std::memcpy(out, first, count * sizeof(P));
+        return out + count;
+    }
+    else {
+        return std::uninitialized_copy_n(first, count, out);
+    }
+}
+
+//      step,  value ( 
+// floor(value / step); +0.0   )
+inline std::uint64_t gridCell(double value, double step) {
+    double cell = std::floor(value / step) + 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &cell, sizeof(bits));
+    return bits;
+}
+
+//  value   ( splitmix64)
+inline std::uint64_t hashCombine(std::uint64_t hash, std::uint64_t value) {
+    std::uint64_t z = hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+//     .  a + b + p + c 
+//           
+//     ; length()  
+// .     -
+// (   auto x = a + b);  ,   auto x = a + Point(1, 1), 
+struct PolylineExpressionTag {};
+
+template<typename E>
+concept PolylineExpression = std::is_base_of_v<PolylineExpressionTag, E>;
+
+//  :  
+template<typename T>
+class PointLeaf {
+private:
+    Point<T> point; //  :   
+
+public:
+    using value_type = T;
+
+    explicit PointLeaf(const Point<T>& point) : point(point) {}
+
+    size_t size() const {
+        return 1;
+    }
+
+    const Point<T>& first() const {
+        return point;
+    }
+
+    const Point<T>& last() const {
+        return point;
+    }
+
+    double length() const {
+        return 0.0;
+    }
+
+    Point<T>* copyTo(Point<T>* out) const {
+        std::construct_at(out, point);
+        return out + 1;
+    }
+
+    template<typename P>
+    static constexpr bool contains = false;
+
+    template<typename P>
+    const P* firstPolyline() const {
+        return nullptr;
+    }
+};
+
+//  :     
+template<typename P>
+class PolylineLeaf {
+private:
+    const P& polyline;
+
+public:
+    using value_type = std::remove_cvref_t<decltype(polyline.begin()->x)>;
+
+    explicit PolylineLeaf(const P& polyline) : polyline(polyline) {}
+
+    size_t size() const {
+        return polyline.size();
+    }
+
+    const auto& first() const {
+        return *polyline.begin();
+    }
+
+    const auto& last() const {
+        return *(polyline.end() - 1);
+    }
+
+    double length() const {
+        return polyline.length();
+    }
+
+    template<typename Out>
+    Out* copyTo(Out* out) const {
+        return uninitializedCopyPoints(polyline.begin(), polyline.size(), out);
+    }
+
+    template<typename Q>
+    static constexpr bool contains = std::is_same_v<P, Q>;
+
+    template<typename Q>
+    const Q* firstPolyline() const {
+        if constexpr (std::is_same_v<P, Q>) return &polyline;
+        else return nullptr;
+    }
+};
+
+//  : left,  right
+template<typename L, typename R>
+class PolylineConcat : public PolylineExpressionTag {
+private:
+    L left;
+    R right;
+
+public:
+    using value_type = typename L::value_type;
+
+    PolylineConcat(L left, R right) : left(std::move(left)), right(std::move(right)) {}
+
+    size_t size() const {
+        return left.size() + right.size();
+    }
+
+    const Point<value_type>& first() const {
+        return left.size() > 0 ? left.first() : right.first();
+    }
+
+    const Point<value_type>& last() const {
+        return right.size() > 0 ? right.last() : left.last();
+    }
+
+    // :       
+    double length() const {
+        double total = left.length() + right.length();
+        if (left.size() > 0 && right.size() > 0) {
+            double dx = static_cast<double>(right.first().x - left.last().x);
+            double dy = static_cast<double>(right.first().y - left.last().y);
+            total += std::sqrt(dx * dx + dy * dy);
+        }
+        return total;
+    }
+
+    Point<value_type>* copyTo(Point<value_type>* out) const {
+        return right.copyTo(left.copyTo(out));
+    }
+
+    template<typename P>
+    static constexpr bool contains = L::template contains<P> || R::template contains<P>;
+
+    //    P   (  )
+    template<typename P>
+    const P* firstPolyline() const {
+        const P* found = left.template firstPolyline<P>();
+        return found ? found : right.template firstPolyline<P>();
+    }
+};
+
+template<typename T>
+PointLeaf<T> asExpressionLeaf(const Point<T>& point) {
+    return PointLeaf<T>(point);
+}
+
+template<PolylineExpression E>
+E asExpressionLeaf(const E& expression) {
+    return expression;
+}
+
+template<typename P>
+PolylineLeaf<P> asExpressionLeaf(const P& polyline) {
+    return PolylineLeaf<P>(polyline);
+}
+
+template<typename L, typename R>
+auto makeConcat(const L& left, const R& right) {
+    auto leftLeaf = asExpressionLeaf(left);
+    auto rightLeaf = asExpressionLeaf(right);
+    return PolylineConcat<decltype(leftLeaf), decltype(rightLeaf)>(std::move(leftLeaf), std::move(rightLeaf));
+}
+
+template<PolylineExpression E, typename R>
+auto operator+(const E& expression, const R& right) {
+    return makeConcat(expression, right);
+}
+
+//  ,    ,   
+template<typename T, PolylineExpression E>
+auto operator+(const Point<T>& point, const E& expression) {
+    return makeConcat(expression, point);
+}
+
+template<typename L, PolylineExpression E>
+    requires (!PolylineExpression<L>)
+auto operator+(const L& left, const E& expression) {
+    return makeConcat(left, expression);
+}
+
+//      (   )
+template<typename P, size_t Count>
+struct InlineBuffer {
+    alignas(P) unsigned char bytes[Count * sizeof(P)];
+
+    P* data() {
+        return reinterpret_cast<P*>(bytes);
+    }
+
+    const P* data() const {
+        return reinterpret_cast<const P*>(bytes);
+    }
+};
+
+template<typename P>
+struct InlineBuffer<P, 0> {
+    P* data() {
+        return nullptr;
+    }
+
+    const P* data() const {
+        return nullptr;
+    }
+};
+
+//       :   64  
+// ,      
+inline std::mutex& cacheMutex(const void* owner) {
+    static std::mutex stripes[64];
+    return stripes[(reinterpret_cast<std::uintptr_t>(owner) >> 6) % 64];
+}
+
+// Allocator -     std::allocator (  
+// std::pmr::polymorphic_allocator  ArenaAllocator).
+// InlineCapacity -        ;
+//     ,    .
+//        :
+//     cacheMutex    .
+//       
+template<typename T, typename Allocator = std::allocator<Point<T>>, size_t InlineCapacity = 4>
+class Polyline {
+private:
+    friend class PolylineSoA<T>;
+
+    using Traits = std::allocator_traits<Allocator>;
+
+    [[no_unique_address]] Allocator allocator; //   
+    [[no_unique_address]] InlineBuffer<Point<T>, InlineCapacity> inlineBuffer; //  
+    Point<T>* points; //  : inlineBuffer,    nullptr;
+                      //    pointCount 
+    size_t pointCount; //  
+    size_t pointCapacity; //  
+
+    //   : prefix[i] -     0   i.
+    //  ; prefixValid -   .
+    //    prefix   updateIndex(), 
+    // prefixValid == pointCount     
+    mutable std::vector<double> prefix{};
+    mutable std::atomic<size_t> prefixValid{0};
+    bool indexed = false; //   
+
+    mutable std::uint64_t hash = 0; //  fingerprint()
+    mutable std::atomic<bool> hashValid{false};
+
+    //  bounds():    ,
+    //    
+    mutable Bounds<T> box{};
+    mutable std::atomic<bool> boundsValid{false};
+
+    using Counter = instrumentation::Counter;
+    using Timer = instrumentation::ScopedTimer<T, Allocator, InlineCapacity>;
+
+    static void count(Counter counter, std::uint64_t amount = 1) {
+        instrumentation::count<T, Allocator, InlineCapacity>(counter, amount);
+    }
+
+    //       
+    Point<T>* allocatePoints(size_t count) {
+        if (count == 0) return nullptr;
+        Polyline::count(Counter::Allocations);
+        Polyline::count(Counter::BytesAllocated, count * sizeof(Point<T>));
+        return Traits::allocate(allocator, count);
+    }
+
+    void deallocatePoints(Point<T>* data, size_t count) {
+        if (data == nullptr) return;
+        Traits::deallocate(allocator, data, count);
+    }
+
+    //    count,    
+    void freeBuffer(Point<T>* data, size_t count) {
+        if (InlineCapacity == 0 || data != inlineBuffer.data()) deallocatePoints(data, count);
+    }
+
+    //  count     to;   
+    static void relocatePoints(Point<T>* from, size_t count, Point<T>* to) {
+        if constexpr (std::is_trivially_copyable_v<Point<T>>) {
+            if (count > 0) std::memcpy(to, from, count * sizeof(Point<T>));
+        }
+        else {
+            std::uninitialized_move_n(from, count, to);
+            std::destroy_n(from, count);
+        }
+    }
+
+    template<PolylineExpression E>
+    static Allocator allocatorFor(const E& expression) {
+        if constexpr (E::template contains<Polyline>) {
+            return Traits::select_on_container_copy_construction(expression.template firstPolyline<Polyline>()->allocator);
+        }
+        else {
+            return Allocator();
+        }
+    }
+
+    // ,     count 
+    static size_t capacityFor(size_t count) {
+        return count <= InlineCapacity ? InlineCapacity : count;
+    }
+
+    bool isInline() const {
+        return InlineCapacity > 0 && points == inlineBuffer.data();
+    }
+
+    //    newCapacity = capacityFor(...) :
+    //    
+    Point<T>* acquire(size_t newCapacity) {
+        if (newCapacity > InlineCapacity) return allocatePoints(newCapacity);
+        return inlineBuffer.data();
+    }
+
+    //  pointCount    
+    void releaseStorage() {
+        if (points != nullptr) {
+            std::destroy_n(points, pointCount);
+            freeBuffer(points, pointCapacity);
+        }
+        points = nullptr;
+        pointCapacity = 0;
+    }
+
+    void resize(size_t newCapacity) {
+        newCapacity = capacityFor(newCapacity);
+        if (newCapacity == pointCapacity) return;
+        Point<T>* newPoints = acquire(newCapacity);
+        count(Counter::PointsCopied, pointCount);
+        relocatePoints(points, pointCount, newPoints);
+        freeBuffer(points, pointCapacity);
+        points = newPoints;
+        pointCapacity = newCapacity;
+    }
+
+    //   other    (points == nullptr).
+    //   ,  - 
+    void takeStorage(Polyline& other) noexcept {
+        if (other.isInline()) {
+            points = acquire(InlineCapacity);
+            pointCapacity = InlineCapacity;
+            count(Counter::PointsCopied, other.pointCount);
+            uninitializedCopyPoints(other.points, other.pointCount, points);
+            other.releaseStorage();
+        }
+        else {
+            points = other.points;
+            pointCapacity = other.pointCapacity;
+            other.points = nullptr;
+            other.pointCapacity = 0;
+        }
+        pointCount = other.pointCount;
+        other.pointCount = 0;
+        prefix = std::move(other.prefix);
+        prefixValid.store(other.prefixValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.prefixValid.store(0, std::memory_order_relaxed);
+        indexed = other.indexed;
+        hash = other.hash;
+        hashValid.store(other.hashValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.hashValid.store(false, std::memory_order_relaxed);
+        box = other.box;
+        boundsValid.store(other.boundsValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.boundsValid.store(false, std::memory_order_relaxed);
+    }
+
+    //     
+    void swapStorage(Polyline& other) noexcept {
+        if (isInline() || other.isInline()) {
+            Polyline temporary(std::move(other));
+            other.takeStorage(*this);
+            takeStorage(temporary);
+            return;
+        }
+        std::swap(points, other.points);
+        std::swap(pointCount, other.pointCount);
+        std::swap(pointCapacity, other.pointCapacity);
+        prefix.swap(other.prefix);
+        size_t valid = prefixValid.load(std::memory_order_relaxed);
+        prefixValid.store(other.prefixValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.prefixValid.store(valid, std::memory_order_relaxed);
+        std::swap(indexed, other.indexed);
+        std::swap(hash, other.hash);
+        bool hashWasValid = hashValid.load(std::memory_order_relaxed);
+        hashValid.store(other.hashValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.hashValid.store(hashWasValid, std::memory_order_relaxed);
+        std::swap(box, other.box);
+        bool boundsWereValid = boundsValid.load(std::memory_order_relaxed);
+        boundsValid.store(other.boundsValid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.boundsValid.store(boundsWereValid, std::memory_order_relaxed);
+    }
+
+    //   :  O(1)  
+    void grow(size_t minCapacity) {
+        count(Counter::Growths);
+        size_t newCapacity = pointCapacity < 4 ? 4 : pointCapacity * 2;
+        if (newCapacity < minCapacity) newCapacity = minCapacity;
+        resize(newCapacity);
+    }
+
+    //        . 
+    //    ,     
+    void updateIndex() const {
+        if (prefixValid.load(std::memory_order_acquire) == pointCount) return;
+        std::lock_guard<std::mutex> lock(cacheMutex(this));
+        size_t valid = prefixValid.load(std::memory_order_relaxed);
+        if (valid == pointCount) return;
+        prefix.resize(pointCount);
+        if (valid == 0) {
+            prefix[0] = 0.0;
+            valid = 1;
+        }
+        for (size_t i = valid; i < pointCount; ++i) {
+            double dx = static_cast<double>(points[i].x - points[i - 1].x);
+            double dy = static_cast<double>(points[i].y - points[i - 1].y);
+            prefix[i] = prefix[i - 1] + std::sqrt(dx * dx + dy * dy);
+        }
+        prefixValid.store(pointCount, std::memory_order_release);
+    }
+
+    //    (segment - 1, segment)   distance  
+    // ; segment    
+    Point<T> interpolate(size_t segment, double distance) const {
+        segment = std::min(segment, pointCount - 1);
+        const Point<T>& a = points[segment - 1];
+        const Point<T>& b = points[segment];
+        double segmentLength = prefix[segment] - prefix[segment - 1];
+        double t = segmentLength > 0.0 ? (distance - prefix[segment - 1]) / segmentLength : 0.0;
+        return Point<T>(static_cast<T>(static_cast<double>(a.x) + t * static_cast<double>(b.x - a.x)),
+                        static_cast<T>(static_cast<double>(a.y) + t * static_cast<double>(b.y - a.y)));
+    }
+
+    //    distance    segment  :
+    //       O(n + m)
+    Point<T> walkTo(size_t& segment, double distance) const {
+        if (distance <= 0.0) return points[0];
+        if (distance >= prefix[pointCount - 1]) return points[pointCount - 1];
+        while (segment + 1 < pointCount && prefix[segment] < distance) ++segment;
+        return interpolate(segment, distance);
+    }
+
+    //  index :     , 
+    //    
+    void touch(size_t index) {
+        if (prefixValid.load(std::memory_order_relaxed) > index) prefixValid.store(index, std::memory_order_relaxed);
+        hashValid.store(false, std::memory_order_relaxed);
+        boundsValid.store(false, std::memory_order_relaxed);
+    }
+
+    //   count ,   first
+    Bounds<T> rangeBounds(size_t first, size_t count) const {
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            return boundsKernels::interleaved(reinterpret_cast<const T*>(points + first), count);
+        }
+        else {
+            Bounds<T> result;
+            for (size_t i = first; i < first + count; ++i) {
+                result.expand(points[i]);
+            }
+            return result;
+        }
+    }
+
+    //      ( )
+    Polyline hull(bool inParallel) const {
+        std::vector<Point<T>> sorted(points, points + pointCount);
+        auto less = [](const Point<T>& a, const Point<T>& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+        parallelSort(sorted.begin(), sorted.end(), less, inParallel ? parallelThreshold : static_cast<size_t>(-1));
+        sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const Point<T>& a, const Point<T>& b) {
+            return a.x == b.x && a.y == b.y;
+        }), sorted.end());
+        size_t n = sorted.size();
+        Allocator resultAllocator = Traits::select_on_container_copy_construction(allocator);
+        if (n < 3) {
+            Polyline result(n, uninitialized, resultAllocator);
+            std::copy(sorted.begin(), sorted.end(), result.points);
+            return result;
+        }
+
+        // ,  o -> a -> b -    
+        auto cross = [](const Point<T>& o, const Point<T>& a, const Point<T>& b) {
+            return static_cast<double>(a.x - o.x) * static_cast<double>(b.y - o.y) -
+                   static_cast<double>(a.y - o.y) * static_cast<double>(b.x - o.x);
+        };
+        std::vector<Point<T>> chain(2 * n);
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            while (k >= 2 && cross(chain[k - 2], chain[k - 1], sorted[i]) <= 0) --k;
+            chain[k++] = sorted[i];
+        }
+        for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+            while (k >= lower && cross(chain[k - 2], chain[k - 1], sorted[i]) <= 0) --k;
+            chain[k++] = sorted[i];
+        }
+        size_t hullSize = k - 1; //      
+
+        Polyline result(hullSize, uninitialized, resultAllocator);
+        std::copy(chain.begin(), chain.begin() + static_cast<std::ptrdiff_t>(hullSize), result.points);
+        return result;
+    }
+
+    //     out (out    points)
+    void transformTo(Point<T>* out, const Affine2<T>& m, bool inParallel) const {
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            const T* in = reinterpret_cast<const T*>(points);
+            if (inParallel && pointCount >= parallelThreshold) {
+                affineKernels::transformParallel(in, reinterpret_cast<T*>(out), pointCount, m);
+            }
+            else {
+                affineKernels::transform(in, reinterpret_cast<T*>(out), pointCount, m);
+            }
+        }
+        else {
+            for (size_t i = 0; i < pointCount; ++i) {
+                out[i] = m(points[i]);
+            }
+        }
+    }
+
+    //    count ,   first
+    double rangeLength(size_t first, size_t count, LengthMode mode) const {
+        const Point<T>* p = points + first;
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            static_assert(sizeof(Point<T>) == 2 * sizeof(T), "Point<T> must be two packed coordinates");
+            if (mode == LengthMode::Fast) {
+                return lengthKernels::interleaved(reinterpret_cast<const T*>(p), count);
+            }
+        }
+        double totalLength = 0.0;
+        for (size_t i = 1; i < count; ++i) {
+            totalLength += std::hypot(p[i].x - p[i - 1].x, p[i].y - p[i - 1].y);
+        }
+        return totalLength;
+    }
+
+public:
+    static const double epsilon; //     
+    static size_t parallelThreshold; //      length()
+
+    using allocator_type = Allocator;
+    using value_type = Point<T>;
+    using size_type = size_t;
+    using iterator = Point<T>*;
+    using const_iterator = const Point<T>*;
+
+    //   :  
+    Polyline(Point<T> point, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(1))), pointCount(1), pointCapacity(capacityFor(1)) {
+        std::construct_at(points, point);
+    }
+
+    //   :  
+    Polyline(size_t numPoints, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(numPoints))), pointCount(numPoints), pointCapacity(capacityFor(numPoints)) {
+        std::uninitialized_fill_n(points, numPoints, Point<T>(0, 0)); //  
+    }
+
+    //   :    
+    // (   ),    
+    Polyline(size_t numPoints, UninitializedTag, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(numPoints))), pointCount(numPoints), pointCapacity(capacityFor(numPoints)) {
+        if constexpr (!std::is_trivially_copyable_v<Point<T>> || !std::is_trivially_destructible_v<Point<T>>) {
+            std::uninitialized_default_construct_n(points, numPoints);
+        }
+    }
+
+    //    (      [m1, m2])
+    Polyline(size_t numPoints, T m1, T m2, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(numPoints))), pointCount(numPoints), pointCapacity(capacityFor(numPoints)) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<T> dis(m1, m2);
+
+        for (size_t i = 0; i < numPoints; ++i) {
+            T x = dis(gen);
+            std::construct_at(points + i, x, dis(gen));
+        }
+    }
+
+    //      [m1, m2),   seed
+    Polyline(size_t numPoints, T m1, T m2, std::uint64_t seed, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(numPoints))), pointCount(numPoints), pointCapacity(capacityFor(numPoints)) {
+        philox::fillUniform(reinterpret_cast<T*>(points), 0, 2 * numPoints, m1, m2, seed);
+    }
+
+    //       ;    
+    Polyline(size_t numPoints, T m1, T m2, std::uint64_t seed, ParallelTag, const Allocator& alloc = Allocator())
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(numPoints))), pointCount(numPoints), pointCapacity(capacityFor(numPoints)) {
+        philox::fillUniformParallel(reinterpret_cast<T*>(points), 2 * numPoints, m1, m2, seed);
+    }
+
+    Polyline(const Polyline& other)
+        : Polyline(other, Traits::select_on_container_copy_construction(other.allocator)) {}
+
+    //     
+    Polyline(const Polyline& other, const Allocator& alloc)
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(other.pointCount))), pointCount(other.pointCount), pointCapacity(capacityFor(other.pointCount)),
+        indexed(other.indexed), hash(0), box() {
+        count(Counter::DeepCopies);
+        count(Counter::PointsCopied, pointCount);
+        uninitializedCopyPoints(other.points, pointCount, points);
+        //  other ,    :   
+        //      
+        if (other.prefixValid.load(std::memory_order_acquire) == other.pointCount && other.pointCount > 0) {
+            prefix.assign(other.prefix.begin(), other.prefix.begin() + static_cast<std::ptrdiff_t>(pointCount));
+            prefixValid.store(pointCount, std::memory_order_relaxed);
+        }
+        if (other.hashValid.load(std::memory_order_acquire)) {
+            hash = other.hash;
+            hashValid.store(true, std::memory_order_relaxed);
+        }
+        if (other.boundsValid.load(std::memory_order_acquire)) {
+            box = other.box;
+            boundsValid.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    //   :     .
+    //          
+    template<PolylineExpression E>
+    Polyline(const E& expression)
+        : Polyline(expression, allocatorFor(expression)) {}
+
+    template<PolylineExpression E>
+    Polyline(const E& expression, const Allocator& alloc)
+        : allocator(alloc), inlineBuffer(), points(acquire(capacityFor(expression.size()))),
+        pointCount(expression.size()), pointCapacity(capacityFor(expression.size())) {
+        count(Counter::PointsCopied, pointCount);
+        expression.copyTo(points);
+    }
+
+    //  :   ,   
+    // (    )
+    Polyline(Polyline&& other) noexcept
+        : allocator(std::move(other.allocator)), inlineBuffer(), points(nullptr), pointCount(0), pointCapacity(0) {
+        takeStorage(other);
+    }
+
+    // 
+    ~Polyline() {
+        releaseStorage();
+    }
+
+    //   
+    Polyline& operator=(const Polyline& other) {
+        if (this != &other) {
+            if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+                Polyline copy(other, other.allocator);
+                releaseStorage();
+                allocator = other.allocator;
+                swapStorage(copy);
+            }
+            else {
+                Polyline copy(other, allocator);
+                swapStorage(copy);
+            }
+        }
+        return *this;
+    }
+
+    //   .  ,  
+    //       ,   
+    Polyline& operator=(Polyline&& other) noexcept(Traits::propagate_on_container_move_assignment::value ||
+                                                   Traits::is_always_equal::value) {
+        if (this != &other) {
+            if constexpr (Traits::propagate_on_container_move_assignment::value) {
+                releaseStorage();
+                pointCount = 0;
+                allocator = std::move(other.allocator);
+                takeStorage(other);
+            }
+            else if (allocator == other.allocator) {
+                Polyline moved(std::move(other));
+                swapStorage(moved);
+            }
+            else {
+                Polyline copy(other, allocator);
+                swapStorage(copy);
+            }
+        }
+        return *this;
+    }
+
+    void swap(Polyline& other) noexcept {
+        if constexpr (Traits::propagate_on_container_swap::value) {
+            std::swap(allocator, other.allocator);
+        }
+        swapStorage(other);
+    }
+
+    allocator_type get_allocator() const {
+        return allocator;
+    }
+
+    //    : length()  length(first, last)
+    //   O(1),      
+    void enableLengthIndex() {
+        indexed = true;
+    }
+
+    void disableLengthIndex() {
+        indexed = false;
+        prefixValid.store(0, std::memory_order_relaxed);
+        std::vector<double>().swap(prefix);
+    }
+
+    bool hasLengthIndex() const {
+        return indexed;
+    }
+
+    //    newCapacity 
+    void reserve(size_t newCapacity) {
+        if (newCapacity > pointCapacity) resize(newCapacity);
+    }
+
+    //   
+    void shrink_to_fit() {
+        if (pointCapacity > pointCount) resize(pointCount);
+    }
+
+    //    
+    void push_back(const Point<T>& point) {
+        Point<T> value = point; // point      
+        if (pointCount == pointCapacity) grow(pointCount + 1);
+        std::construct_at(points + pointCount, value);
+        ++pointCount;
+        hashValid.store(false, std::memory_order_relaxed);
+        if (boundsValid.load(std::memory_order_relaxed)) box.expand(value);
+    }
+
+    //      
+    Polyline& operator+=(const Point<T>& point) {
+        push_back(point);
+        return *this;
+    }
+
+    //         
+    Polyline& operator+=(const Polyline& other) {
+        size_t otherSize = other.pointCount; // other    *this
+        if (pointCount + otherSize > pointCapacity) grow(pointCount + otherSize);
+        count(Counter::PointsCopied, otherSize);
+        uninitializedCopyPoints(other.points, otherSize, points + pointCount);
+        if (boundsValid.load(std::memory_order_relaxed)) box.expand(rangeBounds(pointCount, otherSize));
+        pointCount += otherSize;
+        hashValid.store(false, std::memory_order_relaxed);
+        return *this;
+    }
+
+    //        
+    template<PolylineExpression E>
+    Polyline& operator+=(const E& expression) {
+        size_t added = expression.size();
+        if (pointCount + added > pointCapacity) grow(pointCount + added);
+        //     *this:    ,   pointCount
+        count(Counter::PointsCopied, added);
+        expression.copyTo(points + pointCount);
+        if (boundsValid.load(std::memory_order_relaxed)) box.expand(rangeBounds(pointCount, added));
+        pointCount += added;
+        hashValid.store(false, std::memory_order_relaxed);
+        return *this;
+    }
+
+    size_t size() const {
+        return pointCount;
+    }
+
+    size_t capacity() const {
+        return pointCapacity;
+    }
+
+    bool empty() const {
+        return pointCount == 0;
+    }
+
+    //  []  / 
+    Point<T>& operator[](size_t index) {
+        if (index >= pointCount) throw std::out_of_range("Index out of range");
+        touch(index);
+        return points[index];
+    }
+
+    const Point<T>& operator[](size_t index) const {
+        if (index >= pointCount) throw std::out_of_range("Index out of range");
+        return points[index];
+    }
+
+    Point<T>& at(size_t index) {
+        return (*this)[index];
+    }
+
+    const Point<T>& at(size_t index) const {
+        return (*this)[index];
+    }
+
+    //       
+    Point<T>& at_unchecked(size_t index) {
+        touch(index);
+        return points[index];
+    }
+
+    const Point<T>& at_unchecked(size_t index) const {
+        return points[index];
+    }
+
+    //      (data(), begin(), span()) 
+    //        
+    Point<T>* data() {
+        touch(0);
+        return points;
+    }
+
+    const Point<T>* data() const {
+        return points;
+    }
+
+    //  :    STL,   
+    //   
+    iterator begin() {
+        touch(0);
+        return points;
+    }
+
+    iterator end() {
+        touch(0);
+        return points + pointCount;
+    }
+
+    const_iterator begin() const {
+        return points;
+    }
+
+    const_iterator end() const {
+        return points + pointCount;
+    }
+
+    const_iterator cbegin() const {
+        return points;
+    }
+
+    const_iterator cend() const {
+        return points + pointCount;
+    }
+
+    std::span<Point<T>> span() {
+        touch(0);
+        return std::span<Point<T>>(points, pointCount);
+    }
+
+    std::span<const Point<T>> span() const {
+        return std::span<const Point<T>>(points, pointCount);
+    }
+
+    //     ().  
+    //  (. PolylineConcat),    
+    auto operator+(const Polyline& other) const& {
+        return makeConcat(*this, other);
+    }
+
+    Polyline operator+(const Polyline& other) && {
+        *this += other;
+        return std::move(*this);
+    }
+
+    //      (   )
+    auto operator+(const Point<T>& point) const& {
+        return makeConcat(*this, point);
+    }
+
+    //     :      
+    Polyline operator+(const Point<T>& point) && {
+        push_back(point);
+        return std::move(*this);
+    }
+
+    //      (   )
+    friend auto operator+(const Point<T>& point, const Polyline& polyline) {
+        return polyline + point; //     
+    }
+
+    friend Polyline operator+(const Point<T>& point, Polyline&& polyline) {
+        return std::move(polyline) + point;
+    }
+
+    //   .   Fast  float  double 
+    //  ; Precise   std::hypot
+    double length(LengthMode mode = LengthMode::Fast) const {
+        Timer timer(Counter::LengthCalls, Counter::LengthNanoseconds);
+        if (indexed && mode == LengthMode::Fast && pointCount > 0) {
+            updateIndex();
+            return prefix[pointCount - 1];
+        }
+        return rangeLength(0, pointCount, mode);
+    }
+
+    //      first  last
+    double length(size_t first, size_t last) const {
+        Timer timer(Counter::LengthCalls, Counter::LengthNanoseconds);
+        if (first > last || last >= pointCount) throw std::out_of_range("Index out of range");
+        if (indexed) {
+            updateIndex();
+            return prefix[last] - prefix[first];
+        }
+        return rangeLength(first, last - first + 1, LengthMode::Fast);
+    }
+
+    //     distance   (  ).
+    //   [0, length()]   , NaN .
+    //    ,    
+    Point<T> pointAt(double distance) const {
+        if (pointCount == 0) throw std::out_of_range("Polyline is empty");
+        if (std::isnan(distance)) throw std::invalid_argument("Distance is NaN");
+        updateIndex();
+        if (distance <= 0.0) return points[0];
+        if (distance >= prefix[pointCount - 1]) return points[pointCount - 1];
+        auto end = prefix.begin() + static_cast<std::ptrdiff_t>(pointCount);
+        size_t segment = static_cast<size_t>(std::upper_bound(prefix.begin(), end, distance) - prefix.begin());
+        return interpolate(segment, distance);
+    }
+
+    //   pointAt: out[k] = pointAt(distances[k]).
+    //      ,
+    //   
+    void pointsAt(std::span<const double> distances, std::span<Point<T>> out) const {
+        if (out.size() < distances.size()) throw std::invalid_argument("Output span is too small");
+        if (distances.empty()) return;
+        if (pointCount == 0) throw std::out_of_range("Polyline is empty");
+        if (std::any_of(distances.begin(), distances.end(), [](double d) { return std::isnan(d); })) {
+            throw std::invalid_argument("Distance is NaN");
+        }
+        updateIndex();
+        size_t segment = 1;
+        if (std::is_sorted(distances.begin(), distances.end())) {
+            for (size_t k = 0; k < distances.size(); ++k) {
+                out[k] = walkTo(segment, distances[k]);
+            }
+            return;
+        }
+        std::vector<size_t> order(distances.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+        for (size_t k : order) {
+            out[k] = walkTo(segment, distances[k]);
+        }
+    }
+
+    std::vector<Point<T>> pointsAt(std::span<const double> distances) const {
+        std::vector<Point<T>> out(distances.size());
+        pointsAt(distances, std::span<Point<T>>(out));
+        return out;
+    }
+
+    //    numPoints ,    
+    Polyline resampleUniform(size_t numPoints) const {
+        Polyline result(numPoints, uninitialized, Traits::select_on_container_copy_construction(allocator));
+        if (numPoints == 0) return result;
+        if (pointCount == 0) throw std::out_of_range("Polyline is empty");
+        updateIndex();
+        double total = prefix[pointCount - 1];
+        double step = numPoints > 1 ? total / static_cast<double>(numPoints - 1) : 0.0;
+        size_t segment = 1;
+        for (size_t k = 0; k + 1 < numPoints; ++k) {
+            result.points[k] = walkTo(segment, step * static_cast<double>(k));
+        }
+        //         
+        result.points[numPoints - 1] = numPoints > 1 ? points[pointCount - 1] : points[0];
+        return result;
+    }
+
+    //   ;   parallelThreshold
+    //  
+    double length(ParallelTag, LengthMode mode = LengthMode::Fast) const {
+        if (pointCount < parallelThreshold || (indexed && mode == LengthMode::Fast)) return length(mode);
+        Timer timer(Counter::LengthCalls, Counter::LengthNanoseconds);
+        return lengthKernels::parallelLength(pointCount, [this, mode](size_t first, size_t count) {
+            return rangeLength(first, count, mode);
+        });
+    }
+
+    //      .  float  double
+    //   ;   parallelThreshold
+    //    parallel    
+    Polyline& transform(const Affine2<T>& m) {
+        touch(0);
+        transformTo(points, m, false);
+        return *this;
+    }
+
+    Polyline& transform(const Affine2<T>& m, ParallelTag) {
+        touch(0);
+        transformTo(points, m, true);
+        return *this;
+    }
+
+    //  :      
+    Polyline transformed(const Affine2<T>& m) const {
+        Polyline result(pointCount, uninitialized, Traits::select_on_container_copy_construction(allocator));
+        transformTo(result.points, m, false);
+        return result;
+    }
+
+    Polyline transformed(const Affine2<T>& m, ParallelTag) const {
+        Polyline result(pointCount, uninitialized, Traits::select_on_container_copy_construction(allocator));
+        transformTo(result.points, m, true);
+        return result;
+    }
+
+    //   (dx, dy)
+    Polyline& translate(T dx, T dy) {
+        return transform(Affine2<T>::translation(dx, dy));
+    }
+
+    //   angle    ; sin  cos   
+    Polyline& rotate(double angle) {
+        return transform(Affine2<T>::rotation(angle));
+    }
+
+    //   angle    center
+    Polyline& rotate(double angle, const Point<T>& center) {
+        return transform(Affine2<T>::rotation(angle, center));
+    }
+
+    //    
+    Polyline& scale(T sx, T sy) {
+        return transform(Affine2<T>::scaling(sx, sy));
+    }
+
+    //  ;  float  double - 
+    //  min/max. ,    ;
+    //     ,    
+    const Bounds<T>& bounds() const {
+        if (!boundsValid.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(cacheMutex(this));
+            if (!boundsValid.load(std::memory_order_relaxed)) {
+                box = rangeBounds(0, pointCount);
+                boundsValid.store(true, std::memory_order_release);
+            }
+        }
+        return box;
+    }
+
+    //  :    ,   
+    //  (   ),    ;
+    //      
+    Polyline convexHull() const {
+        return hull(false);
+    }
+
+    //          parallelThreshold
+    Polyline convexHull(ParallelTag) const {
+        return hull(true);
+    }
+
+    //  :   (first < second), 
+    //   x.        
+    std::vector<Intersection<T>> selfIntersections() const {
+        return sweepKernels::selfIntersections(span(), false);
+    }
+
+    //           
+    //  parallelThreshold
+    std::vector<Intersection<T>> selfIntersections(ParallelTag) const {
+        return sweepKernels::selfIntersections(span(), pointCount >= parallelThreshold);
+    }
+
+    //    : first -   , second - .
+    //        
+    std::vector<Intersection<T>> intersections(const Polyline& other) const {
+        return sweepKernels::intersections(span(), bounds(), other.span(), other.bounds(), false);
+    }
+
+    std::vector<Intersection<T>> intersections(const Polyline& other, ParallelTag) const {
+        return sweepKernels::intersections(span(), bounds(), other.span(), other.bounds(),
+                                           pointCount + other.pointCount >= parallelThreshold);
+    }
+
+    //  ,      epsilon.  
+    //    ,      epsilon -
+    //   (    ).    
+    std::uint64_t fingerprint() const {
+        if (!hashValid.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(cacheMutex(this));
+            if (!hashValid.load(std::memory_order_relaxed)) {
+                std::uint64_t result = hashCombine(0, pointCount);
+                for (size_t i = 0; i < pointCount; ++i) {
+                    result = hashCombine(result, gridCell(static_cast<double>(points[i].x), epsilon));
+                    result = hashCombine(result, gridCell(static_cast<double>(points[i].y), epsilon));
+                }
+                hash = result;
+                hashValid.store(true, std::memory_order_release);
+            }
+        }
+        return hash;
+    }
+
+    //    .  float  double - 
+    //      
+    bool operator==(const Polyline& other) const {
+        Timer timer(Counter::EqualityCalls, Counter::EqualityNanoseconds);
+        if (pointCount != other.pointCount) return false;
+        //          epsilon;
+        //     
+        if (boundsValid.load(std::memory_order_acquire) && other.boundsValid.load(std::memory_order_acquire) && pointCount > 0) {
+            if (std::abs(box.min.x - other.box.min.x) > epsilon || std::abs(box.min.y - other.box.min.y) > epsilon ||
+                std::abs(box.max.x - other.box.max.x) > epsilon || std::abs(box.max.y - other.box.max.y) > epsilon) {
+                return false;
+            }
+        }
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            return equalityKernels::nearlyEqual(reinterpret_cast<const T*>(points), reinterpret_cast<const T*>(other.points), 2 * pointCount, epsilon);
+        }
+        for (size_t i = 0; i < pointCount; ++i) {
+            if (std::abs(points[i].x - other.points[i].x) > epsilon ||
+                std::abs(points[i].y - other.points[i].y) > epsilon) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //    
+    bool operator!=(const Polyline& other) const {
+        return !(*this == other);
+    }
+};
+
+//   
+template<typename T, typename Allocator, size_t InlineCapacity>
+const double Polyline<T, Allocator, InlineCapacity>::epsilon = 1e-5;
+
+template<typename T, typename Allocator, size_t InlineCapacity>
+size_t Polyline<T, Allocator, InlineCapacity>::parallelThreshold = size_t(1) << 20;
+
+//    std::pmr::memory_resource
+template<typename T>
+using PmrPolyline = Polyline<T, std::pmr::polymorphic_allocator<Point<T>>>;
+
+//    MonotonicArena
+template<typename T>
+using ArenaPolyline = Polyline<T, ArenaAllocator<Point<T>>>;
+
+//      ( ):
+// x  y     ,  
+//        
+template<typename T>
+class PolylineSoA {
+private:
+    static constexpr size_t alignment = 64; //   
+
+    T* xs; //  
+    T* ys; //  
+    size_t size; //  
+    size_t capacity; //  
+
+    static T* allocate(size_t count) {
+        if (count == 0) return nullptr;
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    static void deallocate(T* ptr) {
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    void resize(size_t newCapacity) {
+        T* newXs = allocate(newCapacity);
+        T* newYs = allocate(newCapacity);
+        for (size_t i = 0; i < size; ++i) {
+            newXs[i] = xs[i];
+            newYs[i] = ys[i];
+        }
+        deallocate(xs);
+        deallocate(ys);
+        xs = newXs;
+        ys = newYs;
+        capacity = newCapacity;
+    }
+
+    void grow(size_t minCapacity) {
+        size_t newCapacity = capacity < 4 ? 4 : capacity * 2;
+        if (newCapacity < minCapacity) newCapacity = minCapacity;
+        resize(newCapacity);
+    }
+
+    double rangeLength(size_t first, size_t count, LengthMode mode) const {
+        const T* x = xs + first;
+        const T* y = ys + first;
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            if (mode == LengthMode::Fast) {
+                return lengthKernels::split(x, y, count);
+            }
+        }
+        double totalLength = 0.0;
+        for (size_t i = 1; i < count; ++i) {
+            totalLength += std::hypot(x[i] - x[i - 1], y[i] - y[i - 1]);
+        }
+        return totalLength;
+    }
+
+public:
+    //   ,      xs  ys
+    struct PointRef {
+        T& x;
+        T& y;
+
+        PointRef& operator=(const Point<T>& point) {
+            x = point.x;
+            y = point.y;
+            return *this;
+        }
+
+        PointRef& operator=(const PointRef& other) {
+            x = other.x;
+            y = other.y;
+            return *this;
+        }
+
+        operator Point<T>() const {
+            return Point<T>(x, y);
+        }
+    };
+
+    static const double epsilon; //     
+
+    //   :  
+    PolylineSoA(Point<T> point) : xs(allocate(1)), ys(allocate(1)), size(1), capacity(1) {
+        xs[0] = point.x;
+        ys[0] = point.y;
+    }
+
+    //   :  
+    PolylineSoA(size_t numPoints) : xs(allocate(numPoints)), ys(allocate(numPoints)), size(numPoints), capacity(numPoints) {
+        for (size_t i = 0; i < numPoints; ++i) {
+            xs[i] = 0;
+            ys[i] = 0;
+        }
+    }
+
+    //    (      [m1, m2])
+    PolylineSoA(size_t numPoints, T m1, T m2) : xs(allocate(numPoints)), ys(allocate(numPoints)), size(numPoints), capacity(numPoints) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<T> dis(m1, m2);
+
+        for (size_t i = 0; i < numPoints; ++i) {
+            xs[i] = dis(gen);
+            ys[i] = dis(gen);
+        }
+    }
+
+    //       
+    explicit PolylineSoA(const Polyline<T>& other) : xs(allocate(other.pointCount)), ys(allocate(other.pointCount)), size(other.pointCount), capacity(other.pointCount) {
+        for (size_t i = 0; i < size; ++i) {
+            xs[i] = other.points[i].x;
+            ys[i] = other.points[i].y;
+        }
+    }
+
+    PolylineSoA(const PolylineSoA& other) : xs(allocate(other.size)), ys(allocate(other.size)), size(other.size), capacity(other.size) {
+        for (size_t i = 0; i < size; ++i) {
+            xs[i] = other.xs[i];
+            ys[i] = other.ys[i];
+        }
+    }
+
+    PolylineSoA(PolylineSoA&& other) noexcept : xs(other.xs), ys(other.ys), size(other.size), capacity(other.capacity) {
+        other.xs = nullptr;
+        other.ys = nullptr;
+        other.size = 0;
+        other.capacity = 0;
+    }
+
+    // 
+    ~PolylineSoA() {
+        deallocate(xs);
+        deallocate(ys);
+    }
+
+    PolylineSoA& operator=(const PolylineSoA& other) {
+        if (this != &other) {
+            PolylineSoA copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    PolylineSoA& operator=(PolylineSoA&& other) noexcept {
+        if (this != &other) {
+            PolylineSoA moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void swap(PolylineSoA& other) noexcept {
+        std::swap(xs, other.xs);
+        std::swap(ys, other.ys);
+        std::swap(size, other.size);
+        std::swap(capacity, other.capacity);
+    }
+
+    //       
+    explicit operator Polyline<T>() const {
+        Polyline<T> result(size, uninitialized);
+        for (size_t i = 0; i < size; ++i) {
+            result.points[i] = Point<T>(xs[i], ys[i]);
+        }
+        return result;
+    }
+
+    void reserve(size_t newCapacity) {
+        if (newCapacity > capacity) resize(newCapacity);
+    }
+
+    void shrink_to_fit() {
+        if (capacity > size) resize(size);
+    }
+
+    void push_back(const Point<T>& point) {
+        if (size == capacity) grow(size + 1);
+        xs[size] = point.x;
+        ys[size] = point.y;
+        ++size;
+    }
+
+    PolylineSoA& operator+=(const Point<T>& point) {
+        push_back(point);
+        return *this;
+    }
+
+    PolylineSoA& operator+=(const PolylineSoA& other) {
+        size_t otherSize = other.size; // other    *this
+        if (size + otherSize > capacity) grow(size + otherSize);
+        for (size_t i = 0; i < otherSize; ++i) {
+            xs[size + i] = other.xs[i];
+            ys[size + i] = other.ys[i];
+        }
+        size += otherSize;
+        return *this;
+    }
+
+    //  []  / 
+    PointRef operator[](size_t index) {
+        if (index >= size) throw std::out_of_range("Index out of range");
+        return PointRef{ xs[index], ys[index] };
+    }
+
+    Point<T> operator[](size_t index) const {
+        if (index >= size) throw std::out_of_range("Index out of range");
+        return Point<T>(xs[index], ys[index]);
+    }
+
+    //     ()
+    PolylineSoA operator+(const PolylineSoA& other) const& {
+        PolylineSoA result(*this);
+        result += other;
+        return result;
+    }
+
+    PolylineSoA operator+(const PolylineSoA& other) && {
+        *this += other;
+        return std::move(*this);
+    }
+
+    //      (   )
+    PolylineSoA operator+(const Point<T>& point) const& {
+        PolylineSoA result(*this);
+        result += point;
+        return result;
+    }
+
+    PolylineSoA operator+(const Point<T>& point) && {
+        push_back(point);
+        return std::move(*this);
+    }
+
+    friend PolylineSoA operator+(const Point<T>& point, const PolylineSoA& polyline) {
+        return polyline + point;
+    }
+
+    friend PolylineSoA operator+(const Point<T>& point, PolylineSoA&& polyline) {
+        return std::move(polyline) + point;
+    }
+
+    //    (. Polyline::length)
+    double length(LengthMode mode = LengthMode::Fast) const {
+        return rangeLength(0, size, mode);
+    }
+
+    double length(ParallelTag, LengthMode mode = LengthMode::Fast) const {
+        if (size < Polyline<T>::parallelThreshold) return length(mode);
+        return lengthKernels::parallelLength(size, [this, mode](size_t first, size_t count) {
+            return rangeLength(first, count, mode);
+        });
+    }
+
+    //    
+    bool operator==(const PolylineSoA& other) const {
+        if (size != other.size) return false;
+        for (size_t i = 0; i < size; ++i) {
+            if (std::abs(xs[i] - other.xs[i]) > epsilon ||
+                std::abs(ys[i] - other.ys[i]) > epsilon) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const PolylineSoA& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename T>
+const double PolylineSoA<T>::epsilon = 1e-5;
+
+//     :     
+//  ,      
+//    .     ,
+//       (std::as_const).
+//  :      
+template<typename T>
+class CowPolyline {
+private:
+    struct Shared {
+        std::atomic<size_t> references; //  
+        Polyline<T> polyline;
+
+        explicit Shared(Polyline<T>&& polyline) : references(1), polyline(std::move(polyline)) {
+            //      const-;     
+            this->polyline.disableLengthIndex();
+        }
+    };
+
+    Shared* shared; // nullptr     
+
+    static const Polyline<T>& emptyPolyline() {
+        static const Polyline<T> empty(size_t(0));
+        return empty;
+    }
+
+    const Polyline<T>& view() const {
+        return shared ? shared->polyline : emptyPolyline();
+    }
+
+    void release() noexcept {
+        if (shared && shared->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete shared;
+        }
+        shared = nullptr;
+    }
+
+    //    :      
+    Polyline<T>& detach() {
+        if (!shared) {
+            shared = new Shared(Polyline<T>(size_t(0)));
+        }
+        else if (shared->references.load(std::memory_order_acquire) > 1) {
+            Shared* copy = new Shared(Polyline<T>(shared->polyline));
+            release();
+            shared = copy;
+        }
+        return shared->polyline;
+    }
+
+public:
+    //   :  
+    CowPolyline(Point<T> point) : shared(new Shared(Polyline<T>(point))) {}
+
+    //   :  
+    CowPolyline(size_t numPoints) : shared(new Shared(Polyline<T>(numPoints))) {}
+
+    //    (      [m1, m2])
+    CowPolyline(size_t numPoints, T m1, T m2) : shared(new Shared(Polyline<T>(numPoints, m1, m2))) {}
+
+    CowPolyline(size_t numPoints, T m1, T m2, std::uint64_t seed) : shared(new Shared(Polyline<T>(numPoints, m1, m2, seed))) {}
+
+    //      
+    explicit CowPolyline(Polyline<T> polyline) : shared(new Shared(std::move(polyline))) {}
+
+    //   O(1):   
+    CowPolyline(const CowPolyline& other) noexcept : shared(other.shared) {
+        if (shared) shared->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CowPolyline(CowPolyline&& other) noexcept : shared(other.shared) {
+        other.shared = nullptr;
+    }
+
+    ~CowPolyline() {
+        release();
+    }
+
+    CowPolyline& operator=(const CowPolyline& other) noexcept {
+        if (shared != other.shared) {
+            CowPolyline copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    CowPolyline& operator=(CowPolyline&& other) noexcept {
+        if (this != &other) {
+            release();
+            shared = other.shared;
+            other.shared = nullptr;
+        }
+        return *this;
+    }
+
+    void swap(CowPolyline& other) noexcept {
+        std::swap(shared, other.shared);
+    }
+
+    //  ,  
+    size_t useCount() const {
+        return shared ? shared->references.load(std::memory_order_relaxed) : 0;
+    }
+
+    //     
+    Polyline<T> toPolyline() const {
+        return view();
+    }
+
+    size_t size() const {
+        return view().size();
+    }
+
+    //  []  :   
+    const Point<T>& operator[](size_t index) const {
+        if (index >= size()) throw std::out_of_range("Index out of range");
+        return view().begin()[index];
+    }
+
+    //  []  :  ,   
+    Point<T>& operator[](size_t index) {
+        if (index >= size()) throw std::out_of_range("Index out of range");
+        return detach()[index];
+    }
+
+    const Point<T>* begin() const {
+        return view().begin();
+    }
+
+    const Point<T>* end() const {
+        return view().end();
+    }
+
+    void reserve(size_t newCapacity) {
+        detach().reserve(newCapacity);
+    }
+
+    void push_back(const Point<T>& point) {
+        detach().push_back(point);
+    }
+
+    CowPolyline& operator+=(const Point<T>& point) {
+        push_back(point);
+        return *this;
+    }
+
+    CowPolyline& operator+=(const CowPolyline& other) {
+        if (&other == this) {
+            CowPolyline copy(other); // detach()  ,    other
+            detach() += copy.view();
+        }
+        else {
+            detach() += other.view();
+        }
+        return *this;
+    }
+
+    double length(LengthMode mode = LengthMode::Fast) const {
+        return view().length(mode);
+    }
+
+    double length(ParallelTag tag, LengthMode mode = LengthMode::Fast) const {
+        return view().length(tag, mode);
+    }
+
+    double length(size_t first, size_t last) const {
+        return view().length(first, last);
+    }
+
+    bool operator==(const CowPolyline& other) const {
+        return shared == other.shared || view() == other.view();
+    }
+
+    bool operator!=(const CowPolyline& other) const {
+        return !(*this == other);
+    }
+};
+
+// -:        .
+// , ,     
+//  O(log n);       ( 
+// chunkCapacity),    ,   
+//   .       .     
+//       ,  length()  O(1)
+template<typename T>
+class PolylineRope {
+public:
+    static constexpr size_t chunkCapacity = 1024; //     
+
+private:
+    struct Node {
+        std::vector<Point<T>> points; //  ,  
+        std::unique_ptr<Node> left;
+        std::unique_ptr<Node> right;
+        std::uint64_t priority;
+        size_t count = 0; //   
+        size_t chunks = 0; //   
+        double chunkLength = 0.0; //   
+        double length = 0.0; //     
+        Point<T> first{};
+        Point<T> last{};
+
+        Node(std::vector<Point<T>> points, std::uint64_t priority)
+            : points(std::move(points)), left(), right(), priority(priority) {
+            measure();
+            update();
+        }
+
+        //       
+        void measure() {
+            const Point<T>* p = points.data();
+            if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+                chunkLength = lengthKernels::interleaved(reinterpret_cast<const T*>(p), points.size());
+            }
+            else {
+                chunkLength = 0.0;
+                for (size_t i = 1; i < points.size(); ++i) {
+                    chunkLength += distance(p[i - 1], p[i]);
+                }
+            }
+        }
+
+        //     
+        void update() {
+            count = points.size();
+            chunks = 1;
+            length = chunkLength;
+            first = points.front();
+            last = points.back();
+            if (left) {
+                count += left->count;
+                chunks += left->chunks;
+                length += left->length + distance(left->last, first);
+                first = left->first;
+            }
+            if (right) {
+                count += right->count;
+                chunks += right->chunks;
+                length += right->length + distance(last, right->first);
+                last = right->last;
+            }
+        }
+    };
+
+    using NodePtr = std::unique_ptr<Node>;
+
+    NodePtr root;
+
+    static double distance(const Point<T>& a, const Point<T>& b) {
+        return static_cast<double>(std::hypot(b.x - a.x, b.y - a.y));
+    }
+
+    //  : splitmix64   
+    static std::uint64_t nextPriority() {
+        thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static NodePtr makeNode(std::vector<Point<T>> points) {
+        return std::make_unique<Node>(std::move(points), nextPriority());
+    }
+
+    static size_t countOf(const NodePtr& node) {
+        return node ? node->count : 0;
+    }
+
+    //    :   
+    //        
+    static NodePtr clone(const PolylineRope& other) {
+        NodePtr copy;
+        other.forEachChunk([&](const Point<T>* points, size_t count) {
+            copy = merge(std::move(copy), makeNode(std::vector<Point<T>>(points, points + count)));
+        });
+        return copy;
+    }
+
+    static NodePtr merge(NodePtr a, NodePtr b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->priority > b->priority) {
+            a->right = merge(std::move(a->right), std::move(b));
+            a->update();
+            return a;
+        }
+        b->left = merge(std::move(a), std::move(b->left));
+        b->update();
+        return b;
+    }
+
+    //    index   ;      
+    static std::pair<NodePtr, NodePtr> split(NodePtr node, size_t index) {
+        if (!node) return {};
+        size_t leftCount = countOf(node->left);
+        size_t chunkSize = node->points.size();
+        if (index <= leftCount) {
+            auto [a, b] = split(std::move(node->left), index);
+            node->left = std::move(b);
+            node->update();
+            return { std::move(a), std::move(node) };
+        }
+        if (index >= leftCount + chunkSize) {
+            auto [a, b] = split(std::move(node->right), index - leftCount - chunkSize);
+            node->right = std::move(a);
+            node->update();
+            return { std::move(node), std::move(b) };
+        }
+        size_t offset = index - leftCount;
+        NodePtr tail = makeNode(std::vector<Point<T>>(node->points.begin() + static_cast<std::ptrdiff_t>(offset), node->points.end()));
+        node->points.resize(offset);
+        node->measure();
+        NodePtr right = std::move(node->right);
+        node->update();
+        return { std::move(node), merge(std::move(tail), std::move(right)) };
+    }
+
+    //    (popFront)   (popBack) 
+    //    ;     
+    static std::vector<Point<T>> popFront(NodePtr& tree) {
+        if (tree->left) {
+            std::vector<Point<T>> points = popFront(tree->left);
+            tree->update();
+            return points;
+        }
+        std::vector<Point<T>> points = std::move(tree->points);
+        tree = std::move(tree->right);
+        return points;
+    }
+
+    static std::vector<Point<T>> popBack(NodePtr& tree) {
+        if (tree->right) {
+            std::vector<Point<T>> points = popBack(tree->right);
+            tree->update();
+            return points;
+        }
+        std::vector<Point<T>> points = std::move(tree->points);
+        tree = std::move(tree->left);
+        return points;
+    }
+
+    //  ,     a    b
+    // ,     chunkCapacity
+    static NodePtr join(NodePtr a, NodePtr b) {
+        if (a && b) {
+            std::vector<Node*> path;
+            for (Node* node = a.get(); node; node = node->right.get()) {
+                path.push_back(node);
+            }
+            const Node* first = b.get();
+            while (first->left) {
+                first = first->left.get();
+            }
+            Node* last = path.back();
+            if (last->points.size() + first->points.size() <= chunkCapacity) {
+                std::vector<Point<T>> points = popFront(b);
+                last->points.insert(last->points.end(), points.begin(), points.end());
+                last->measure();
+                for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                    (*it)->update();
+                }
+            }
+        }
+        return merge(std::move(a), std::move(b));
+    }
+
+    //   :   ,   ,
+    //   ,       
+    static NodePtr stitch(NodePtr a, NodePtr b) {
+        if (a) {
+            std::vector<Point<T>> points = popBack(a);
+            a = join(std::move(a), makeNode(std::move(points)));
+        }
+        if (b) {
+            std::vector<Point<T>> points = popFront(b);
+            b = join(makeNode(std::move(points)), std::move(b));
+        }
+        return join(std::move(a), std::move(b));
+    }
+
+    //          ,   
+    static void append(NodePtr& tree, const Point<T>& point) {
+        std::vector<Node*> path;
+        for (Node* node = tree.get(); node; node = node->right.get()) {
+            path.push_back(node);
+        }
+        if (path.empty() || path.back()->points.size() >= chunkCapacity) {
+            tree = merge(std::move(tree), makeNode({ point }));
+            return;
+        }
+        Node* last = path.back();
+        last->chunkLength += distance(last->points.back(), point);
+        last->points.push_back(point);
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            (*it)->update();
+        }
+    }
+
+    void checkIndex(size_t index) const {
+        if (index >= size()) throw std::out_of_range("Index out of range");
+    }
+
+public:
+    PolylineRope() : root() {}
+
+    //   :  
+    PolylineRope(Point<T> point) : root(makeNode({ point })) {}
+
+    //     
+    explicit PolylineRope(const Polyline<T>& polyline) : root() {
+        const Point<T>* first = polyline.begin();
+        const Point<T>* last = polyline.end();
+        while (first != last) {
+            size_t count = std::min(chunkCapacity, static_cast<size_t>(last - first));
+            root = merge(std::move(root), makeNode(std::vector<Point<T>>(first, first + count)));
+            first += count;
+        }
+    }
+
+    PolylineRope(const PolylineRope& other) : root(clone(other)) {}
+
+    PolylineRope(PolylineRope&& other) noexcept = default;
+
+    PolylineRope& operator=(const PolylineRope& other) {
+        if (this != &other) {
+            root = clone(other);
+        }
+        return *this;
+    }
+
+    PolylineRope& operator=(PolylineRope&& other) noexcept = default;
+
+    ~PolylineRope() = default;
+
+    size_t size() const {
+        return countOf(root);
+    }
+
+    bool empty() const {
+        return !root;
+    }
+
+    //  
+    size_t chunkCount() const {
+        return root ? root->chunks : 0;
+    }
+
+    double length() const {
+        return root ? root->length : 0.0;
+    }
+
+    const Point<T>& operator[](size_t index) const {
+        checkIndex(index);
+        const Node* node = root.get();
+        while (true) {
+            size_t leftCount = countOf(node->left);
+            if (index < leftCount) {
+                node = node->left.get();
+            }
+            else if (index < leftCount + node->points.size()) {
+                return node->points[index - leftCount];
+            }
+            else {
+                index -= leftCount + node->points.size();
+                node = node->right.get();
+            }
+        }
+    }
+
+    //            
+    void set(size_t index, const Point<T>& point) {
+        checkIndex(index);
+        std::vector<Node*> path;
+        Node* node = root.get();
+        while (true) {
+            path.push_back(node);
+            size_t leftCount = countOf(node->left);
+            if (index < leftCount) {
+                node = node->left.get();
+            }
+            else if (index < leftCount + node->points.size()) {
+                node->points[index - leftCount] = point;
+                node->measure();
+                break;
+            }
+            else {
+                index -= leftCount + node->points.size();
+                node = node->right.get();
+            }
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            (*it)->update();
+        }
+    }
+
+    void push_back(const Point<T>& point) {
+        append(root, point);
+    }
+
+    //     index     index - 1 (
+    // index = 0 -   ).    
+    void insert(size_t index, const Point<T>& point) {
+        if (index > size()) throw std::out_of_range("Index out of range");
+        if (!root) {
+            root = makeNode({ point });
+            return;
+        }
+        size_t target = index == 0 ? 0 : index - 1;
+        size_t chunkStart = 0;
+        std::vector<Node*> path;
+        Node* node = root.get();
+        while (true) {
+            path.push_back(node);
+            size_t leftCount = countOf(node->left);
+            if (target < leftCount) {
+                node = node->left.get();
+            }
+            else if (target < leftCount + node->points.size()) {
+                chunkStart += leftCount;
+                size_t offset = index == 0 ? 0 : target - leftCount + 1;
+                node->points.insert(node->points.begin() + static_cast<std::ptrdiff_t>(offset), point);
+                node->measure();
+                break;
+            }
+            else {
+                target -= leftCount + node->points.size();
+                chunkStart += leftCount + node->points.size();
+                node = node->right.get();
+            }
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            (*it)->update();
+        }
+        if (node->points.size() > chunkCapacity) {
+            auto [head, tail] = split(std::move(root), chunkStart + node->points.size() / 2);
+            root = stitch(std::move(head), std::move(tail));
+        }
+    }
+
+    //      index   
+    void insert(size_t index, PolylineRope&& other) {
+        if (index > size()) throw std::out_of_range("Index out of range");
+        auto [head, tail] = split(std::move(root), index);
+        root = stitch(stitch(std::move(head), std::move(other.root)), std::move(tail));
+    }
+
+    //   [first, last)
+    void erase(size_t first, size_t last) {
+        if (first > last || last > size()) throw std::out_of_range("Index out of range");
+        auto [head, rest] = split(std::move(root), first);
+        auto [removed, tail] = split(std::move(rest), last - first);
+        root = stitch(std::move(head), std::move(tail));
+    }
+
+    void erase(size_t index) {
+        erase(index, index + 1);
+    }
+
+    //     index   
+    PolylineRope split(size_t index) {
+        if (index > size()) throw std::out_of_range("Index out of range");
+        auto [head, tail] = split(std::move(root), index);
+        root = stitch(std::move(head), nullptr);
+        PolylineRope result;
+        result.root = stitch(nullptr, std::move(tail));
+        return result;
+    }
+
+    //   O(log n):      
+    PolylineRope& operator+=(PolylineRope&& other) {
+        if (this != &other) {
+            root = join(std::move(root), std::move(other.root));
+        }
+        return *this;
+    }
+
+    PolylineRope& operator+=(const PolylineRope& other) {
+        return *this += PolylineRope(other);
+    }
+
+    friend PolylineRope operator+(PolylineRope left, PolylineRope&& right) {
+        left += std::move(right);
+        return left;
+    }
+
+    friend PolylineRope operator+(PolylineRope left, const PolylineRope& right) {
+        left += right;
+        return left;
+    }
+
+    //    : f(const Point<T>* points, size_t count)
+    template<typename F>
+    void forEachChunk(F f) const {
+        std::vector<const Node*> stack;
+        const Node* node = root.get();
+        while (node || !stack.empty()) {
+            while (node) {
+                stack.push_back(node);
+                node = node->left.get();
+            }
+            node = stack.back();
+            stack.pop_back();
+            f(node->points.data(), node->points.size());
+            node = node->right.get();
+        }
+    }
+
+    //   
+    Polyline<T> toPolyline() const {
+        Polyline<T> result(size_t(0));
+        result.reserve(size());
+        forEachChunk([&](const Point<T>* points, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                result.push_back(points[i]);
+            }
+        });
+        return result;
+    }
+};
+
+//      .  
+// ,  (operator==,   epsilon)  .
+//        (  
+//   ),  -      ,  
+//        3 * epsilon.   
+// ,    -   
+template<typename T>
+class PolylineDeduplicator {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    std::vector<Polyline<T>> unique; // 
+    std::unordered_map<std::uint64_t, std::vector<size_t>> byFingerprint;
+    std::unordered_map<std::uint64_t, std::vector<size_t>> byEndpoints;
+
+    static double cellStep() {
+        return 3.0 * Polyline<T>::epsilon;
+    }
+
+    static std::uint64_t endpointKey(size_t count, const std::uint64_t (&cells)[4]) {
+        std::uint64_t key = hashCombine(0, count);
+        for (std::uint64_t cell : cells) {
+            key = hashCombine(key, cell);
+        }
+        return key;
+    }
+
+    //      
+    static std::uint64_t ownKey(const Polyline<T>& polyline) {
+        std::uint64_t cells[4] = {};
+        if (!polyline.empty()) {
+            const Point<T>& first = polyline.begin()[0];
+            const Point<T>& last = polyline.end()[-1];
+            double step = cellStep();
+            cells[0] = gridCell(static_cast<double>(first.x), step);
+            cells[1] = gridCell(static_cast<double>(first.y), step);
+            cells[2] = gridCell(static_cast<double>(last.x), step);
+            cells[3] = gridCell(static_cast<double>(last.y), step);
+        }
+        return endpointKey(polyline.size(), cells);
+    }
+
+    //  f(key)    ,     
+    // epsilon   polyline:       
+    template<typename F>
+    static void forEachNeighborKey(const Polyline<T>& polyline, F f) {
+        if (polyline.empty()) {
+            f(ownKey(polyline));
+            return;
+        }
+        const Point<T>& first = polyline.begin()[0];
+        const Point<T>& last = polyline.end()[-1];
+        double coordinates[4] = { static_cast<double>(first.x), static_cast<double>(first.y),
+                                  static_cast<double>(last.x), static_cast<double>(last.y) };
+        //  [v - 1.5 eps, v + 1.5 eps]         
+        double step = cellStep();
+        double reach = 0.5 * step;
+        std::uint64_t options[4][2];
+        int optionCount[4];
+        for (int axis = 0; axis < 4; ++axis) {
+            options[axis][0] = gridCell(coordinates[axis] - reach, step);
+            options[axis][1] = gridCell(coordinates[axis] + reach, step);
+            optionCount[axis] = options[axis][0] == options[axis][1] ? 1 : 2;
+        }
+        std::uint64_t cells[4];
+        for (int a = 0; a < optionCount[0]; ++a) {
+            cells[0] = options[0][a];
+            for (int b = 0; b < optionCount[1]; ++b) {
+                cells[1] = options[1][b];
+                for (int c = 0; c < optionCount[2]; ++c) {
+                    cells[2] = options[2][c];
+                    for (int d = 0; d < optionCount[3]; ++d) {
+                        cells[3] = options[3][d];
+                        f(endpointKey(polyline.size(), cells));
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    PolylineDeduplicator() : unique(), byFingerprint(), byEndpoints() {}
+
+    void reserve(size_t count) {
+        unique.reserve(count);
+        byFingerprint.reserve(count);
+        byEndpoints.reserve(count);
+    }
+
+    //  ,  polyline,  npos
+    size_t find(const Polyline<T>& polyline) const {
+        std::uint64_t fingerprint = polyline.fingerprint();
+        auto exact = byFingerprint.find(fingerprint);
+        if (exact != byFingerprint.end()) {
+            for (size_t index : exact->second) {
+                if (unique[index] == polyline) return index;
+            }
+        }
+        size_t found = npos;
+        forEachNeighborKey(polyline, [&](std::uint64_t key) {
+            if (found != npos) return;
+            auto bucket = byEndpoints.find(key);
+            if (bucket == byEndpoints.end()) return;
+            for (size_t index : bucket->second) {
+                //       
+                if (unique[index].fingerprint() != fingerprint && unique[index] == polyline) {
+                    found = index;
+                    return;
+                }
+            }
+        });
+        return found;
+    }
+
+    //  ,      .
+    //      
+    size_t insert(const Polyline<T>& polyline) {
+        size_t index = find(polyline);
+        if (index != npos) return index;
+        index = unique.size();
+        unique.push_back(polyline);
+        byFingerprint[polyline.fingerprint()].push_back(index);
+        byEndpoints[ownKey(polyline)].push_back(index);
+        return index;
+    }
+
+    //   
+    size_t size() const {
+        return unique.size();
+    }
+
+    const Polyline<T>& operator[](size_t index) const {
+        if (index >= unique.size()) throw std::out_of_range("Index out of range");
+        return unique[index];
+    }
+
+    const std::vector<Polyline<T>>& polylines() const {
+        return unique;
+    }
+};
+
+//    :  R-,
+//   STR (Sort-Tile-Recursive).    
+//       ,     
+//  ,       .
+//     ,   :   
+//     ,   .  
+//   
+template<typename T>
+class SegmentIndex {
+public:
+    static constexpr size_t nodeCapacity = 16; //   
+
+    //     
+    struct Nearest {
+        Point<T> point{}; //  
+        size_t segment = 0; //  (segment, segment + 1),    
+        double distance = 0.0; //   
+    };
+
+private:
+    struct Node {
+        Bounds<T> box{};
+        std::uint32_t first = 0; //  :  order  ,  nodes  
+        std::uint32_t count = 0;
+    };
+
+    std::span<const Point<T>> points;
+    std::vector<std::uint32_t> order{}; //     
+    std::vector<Node> nodes{}; // ,   ;  
+    size_t leafCount = 0;
+
+    size_t segmentCount() const {
+        return points.size() < 2 ? points.size() : points.size() - 1;
+    }
+
+    //  ;     -  
+    const Point<T>& start(size_t segment) const {
+        return points[segment];
+    }
+
+    const Point<T>& finish(size_t segment) const {
+        return points[std::min(segment + 1, points.size() - 1)];
+    }
+
+    Bounds<T> segmentBounds(size_t segment) const {
+        Bounds<T> box;
+        box.expand(start(segment));
+        box.expand(finish(segment));
+        return box;
+    }
+
+    bool isLeaf(size_t node) const {
+        return node < leafCount;
+    }
+
+    //  f(0) ... f(tasks - 1),      
+    template<typename F>
+    static void run(size_t tasks, bool inParallel, F f) {
+        if (inParallel) {
+            parallelFor(tasks, f);
+            return;
+        }
+        for (size_t i = 0; i < tasks; ++i) {
+            f(i);
+        }
+    }
+
+    // STR-:  x ,   y   
+    //  ceil(sqrt( ))  
+    template<typename Center>
+    void strOrder(std::vector<std::uint32_t>& items, Center center, bool inParallel) const {
+        size_t count = items.size();
+        size_t groups = (count + nodeCapacity - 1) / nodeCapacity;
+        size_t slabs = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(groups))));
+        size_t slabSize = slabs == 0 ? count : (groups + slabs - 1) / slabs * nodeCapacity;
+        parallelSort(items.begin(), items.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return center(a).x < center(b).x;
+        }, inParallel ? size_t(0) : static_cast<size_t>(-1));
+        size_t slabCount = slabSize == 0 ? 0 : (count + slabSize - 1) / slabSize;
+        run(slabCount, inParallel, [&](size_t slab) {
+            auto first = items.begin() + static_cast<std::ptrdiff_t>(slab * slabSize);
+            auto last = items.begin() + static_cast<std::ptrdiff_t>(std::min(count, (slab + 1) * slabSize));
+            std::sort(first, last, [&](std::uint32_t a, std::uint32_t b) { return center(a).y < center(b).y; });
+        });
+    }
+
+    static Point<double> center(const Bounds<T>& box) {
+        return Point<double>((static_cast<double>(box.min.x) + static_cast<double>(box.max.x)) / 2,
+                             (static_cast<double>(box.min.y) + static_cast<double>(box.max.y)) / 2);
+    }
+
+    void build() {
+        size_t count = segmentCount();
+        if (count == 0) return;
+        if (count > std::numeric_limits<std::uint32_t>::max()) throw std::length_error("Too many segments for SegmentIndex");
+        bool inParallel = count >= Polyline<T>::parallelThreshold;
+        size_t chunk = lengthKernels::parallelChunkSize;
+
+        std::vector<Bounds<T>> boxes(count);
+        run((count + chunk - 1) / chunk, inParallel, [&](size_t block) {
+            for (size_t i = block * chunk; i < std::min(count, (block + 1) * chunk); ++i) {
+                boxes[i] = segmentBounds(i);
+            }
+        });
+        order.resize(count);
+        std::iota(order.begin(), order.end(), std::uint32_t(0));
+        strOrder(order, [&](std::uint32_t i) { return center(boxes[i]); }, inParallel);
+
+        //   ,    ,    
+        size_t levelSize = (count + nodeCapacity - 1) / nodeCapacity;
+        size_t total = levelSize;
+        for (size_t size = levelSize; size > 1; size = (size + nodeCapacity - 1) / nodeCapacity) {
+            total += (size + nodeCapacity - 1) / nodeCapacity;
+        }
+        nodes.resize(total);
+        leafCount = levelSize;
+        run((levelSize + chunk - 1) / chunk, inParallel, [&](size_t block) {
+            for (size_t k = block * chunk; k < std::min(levelSize, (block + 1) * chunk); ++k) {
+                Node& node = nodes[k];
+                node.first = static_cast<std::uint32_t>(k * nodeCapacity);
+                node.count = static_cast<std::uint32_t>(std::min(nodeCapacity, count - k * nodeCapacity));
+                node.box = Bounds<T>();
+                for (size_t j = node.first; j < node.first + node.count; ++j) {
+                    node.box.expand(boxes[order[j]]);
+                }
+            }
+        });
+
+        size_t levelStart = 0;
+        std::vector<std::uint32_t> items;
+        std::vector<Node> permuted;
+        while (levelSize > 1) {
+            //   ;        
+            items.resize(levelSize);
+            std::iota(items.begin(), items.end(), std::uint32_t(0));
+            strOrder(items, [&](std::uint32_t i) { return center(nodes[levelStart + i].box); }, inParallel);
+            permuted.resize(levelSize);
+            for (size_t i = 0; i < levelSize; ++i) {
+                permuted[i] = nodes[levelStart + items[i]];
+            }
+            std::copy(permuted.begin(), permuted.end(), nodes.begin() + static_cast<std::ptrdiff_t>(levelStart));
+
+            size_t parentStart = levelStart + levelSize;
+            size_t parents = (levelSize + nodeCapacity - 1) / nodeCapacity;
+            for (size_t k = 0; k < parents; ++k) {
+                Node& node = nodes[parentStart + k];
+                node.first = static_cast<std::uint32_t>(levelStart + k * nodeCapacity);
+                node.count = static_cast<std::uint32_t>(std::min(nodeCapacity, levelSize - k * nodeCapacity));
+                node.box = Bounds<T>();
+                for (size_t j = node.first; j < node.first + node.count; ++j) {
+                    node.box.expand(nodes[j].box);
+                }
+            }
+            levelStart = parentStart;
+            levelSize = parents;
+        }
+    }
+
+    //    q   (0 )
+    static double distance2(const Bounds<T>& box, const Point<T>& q) {
+        double qx = static_cast<double>(q.x);
+        double qy = static_cast<double>(q.y);
+        double dx = std::max({ static_cast<double>(box.min.x) - qx, 0.0, qx - static_cast<double>(box.max.x) });
+        double dy = std::max({ static_cast<double>(box.min.y) - qy, 0.0, qy - static_cast<double>(box.max.y) });
+        return dx * dx + dy * dy;
+    }
+
+    //   q       
+    std::pair<Point<double>, double> closestOnSegment(size_t segment, const Point<T>& q) const {
+        double ax = static_cast<double>(start(segment).x);
+        double ay = static_cast<double>(start(segment).y);
+        double dx = static_cast<double>(finish(segment).x) - ax;
+        double dy = static_cast<double>(finish(segment).y) - ay;
+        double qx = static_cast<double>(q.x);
+        double qy = static_cast<double>(q.y);
+        double lengthSquared = dx * dx + dy * dy;
+        double t = lengthSquared > 0.0 ? std::clamp(((qx - ax) * dx + (qy - ay) * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+        Point<double> closest(ax + t * dx, ay + t * dy);
+        double ex = closest.x - qx;
+        double ey = closest.y - qy;
+        return { closest, ex * ex + ey * ey };
+    }
+
+    //     (  - )
+    bool segmentIntersects(size_t segment, const Bounds<T>& rect) const {
+        double x0 = static_cast<double>(start(segment).x);
+        double y0 = static_cast<double>(start(segment).y);
+        double dx = static_cast<double>(finish(segment).x) - x0;
+        double dy = static_cast<double>(finish(segment).y) - y0;
+        double enter = 0.0;
+        double leave = 1.0;
+        auto clip = [&](double p, double q) {
+            if (p == 0.0) return q >= 0.0;
+            double r = q / p;
+            if (p < 0.0) enter = std::max(enter, r);
+            else leave = std::min(leave, r);
+            return enter <= leave;
+        };
+        return clip(-dx, x0 - static_cast<double>(rect.min.x)) && clip(dx, static_cast<double>(rect.max.x) - x0) &&
+               clip(-dy, y0 - static_cast<double>(rect.min.y)) && clip(dy, static_cast<double>(rect.max.y) - y0);
+    }
+
+public:
+    explicit SegmentIndex(std::span<const Point<T>> points) : points(points) {
+        build();
+    }
+
+    template<typename Allocator, size_t InlineCapacity>
+    explicit SegmentIndex(const Polyline<T, Allocator, InlineCapacity>& polyline) : SegmentIndex(polyline.span()) {}
+
+    template<typename Allocator, size_t InlineCapacity>
+    SegmentIndex(Polyline<T, Allocator, InlineCapacity>&&) = delete;
+
+    size_t size() const {
+        return segmentCount();
+    }
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    //   q  :     
+    //    
+    Nearest nearestPoint(const Point<T>& q) const {
+        if (empty()) throw std::out_of_range("Polyline is empty");
+        using Entry = std::pair<double, std::uint32_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        queue.emplace(distance2(nodes.back().box, q), static_cast<std::uint32_t>(nodes.size() - 1));
+        double best = std::numeric_limits<double>::infinity();
+        Point<double> bestPoint;
+        size_t bestSegment = 0;
+        while (!queue.empty()) {
+            auto [distance, index] = queue.top();
+            queue.pop();
+            if (distance >= best) break;
+            const Node& node = nodes[index];
+            for (std::uint32_t j = node.first; j < node.first + node.count; ++j) {
+                if (isLeaf(index)) {
+                    auto [closest, d] = closestOnSegment(order[j], q);
+                    if (d < best || (d == best && order[j] < bestSegment)) {
+                        best = d;
+                        bestPoint = closest;
+                        bestSegment = order[j];
+                    }
+                }
+                else {
+                    double d = distance2(nodes[j].box, q);
+                    if (d < best) queue.emplace(d, j);
+                }
+            }
+        }
+        Nearest result;
+        result.point = Point<T>(static_cast<T>(bestPoint.x), static_cast<T>(bestPoint.y));
+        result.segment = bestSegment;
+        result.distance = std::sqrt(best);
+        return result;
+    }
+
+    //  ,   rect,  
+    std::vector<size_t> segmentsInRect(const Bounds<T>& rect) const {
+        std::vector<size_t> result;
+        if (empty() || !nodes.back().box.intersects(rect)) return result;
+        std::vector<std::uint32_t> stack{ static_cast<std::uint32_t>(nodes.size() - 1) };
+        while (!stack.empty()) {
+            std::uint32_t index = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[index];
+            for (std::uint32_t j = node.first; j < node.first + node.count; ++j) {
+                if (isLeaf(index)) {
+                    if (segmentBounds(order[j]).intersects(rect) && segmentIntersects(order[j], rect)) result.push_back(order[j]);
+                }
+                else if (nodes[j].box.intersects(rect)) {
+                    stack.push_back(j);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    //  :      
+    void nearestPoints(std::span<const Point<T>> queries, std::span<Nearest> out) const {
+        if (out.size() < queries.size()) throw std::invalid_argument("Output span is too small");
+        if (queries.empty()) return;
+        if (empty()) throw std::out_of_range("Polyline is empty");
+        constexpr size_t block = 1024;
+        parallelFor((queries.size() + block - 1) / block, [&](size_t b) {
+            for (size_t i = b * block; i < std::min(queries.size(), (b + 1) * block); ++i) {
+                out[i] = nearestPoint(queries[i]);
+            }
+        });
+    }
+
+    std::vector<Nearest> nearestPoints(std::span<const Point<T>> queries) const {
+        std::vector<Nearest> out(queries.size());
+        nearestPoints(queries, std::span<Nearest>(out));
+        return out;
+    }
+
+    std::vector<std::vector<size_t>> segmentsInRects(std::span<const Bounds<T>> rects) const {
+        std::vector<std::vector<size_t>> out(rects.size());
+        constexpr size_t block = 256;
+        parallelFor((rects.size() + block - 1) / block, [&](size_t b) {
+            for (size_t i = b * block; i < std::min(rects.size(), (b + 1) * block); ++i) {
+                out[i] = segmentsInRect(rects[i]);
+            }
+        });
+        return out;
+    }
+};
+
+//      [first, last).
+//    : Polyline, ProceduralPolyline  ..
+template<std::forward_iterator It>
+double polylineLength(It first, It last) {
+    double totalLength = 0.0;
+    if (first == last) return totalLength;
+    auto previous = *first;
+    for (++first; first != last; ++first) {
+        auto current = *first;
+        double dx = static_cast<double>(current.x - previous.x);
+        double dy = static_cast<double>(current.y - previous.y);
+        totalLength += std::sqrt(dx * dx + dy * dy);
+        previous = current;
+    }
+    return totalLength;
+}
+
+template<std::forward_iterator It1, std::forward_iterator It2>
+bool polylinesEqual(It1 first1, It1 last1, It2 first2, It2 last2, double epsilon) {
+    for (; first1 != last1 && first2 != last2; ++first1, ++first2) {
+        auto a = *first1;
+        auto b = *first2;
+        if (std::abs(static_cast<double>(a.x) - static_cast<double>(b.x)) > epsilon ||
+            std::abs(static_cast<double>(a.y) - static_cast<double>(b.y)) > epsilon) {
+            return false;
+        }
+    }
+    return first1 == last1 && first2 == last2;
+}
+
+//    :  index   
+// index  Polyline<T>(numPoints, m1, m2, seed)
+template<typename T>
+struct RandomPointGenerator {
+    T m1;
+    T m2;
+    std::uint64_t seed;
+
+    Point<T> operator()(size_t index) const {
+        return philox::uniformPoint(index, m1, m2, seed);
+    }
+};
+
+// -:  i   generator(i)
+//       .  -  
+//   size_t -> Point<T>
+template<typename T, typename Generator>
+class ProceduralPolyline {
+private:
+    size_t count; //  
+    Generator generator; //   -> 
+
+public:
+    class iterator {
+    private:
+        const ProceduralPolyline* owner = nullptr;
+        size_t index = 0;
+
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Point<T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = Point<T>;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(const ProceduralPolyline* owner, size_t index) : owner(owner), index(index) {}
+
+        Point<T> operator*() const {
+            return owner->generator(index);
+        }
+
+        iterator& operator++() {
+            ++index;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++index;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const {
+            return index == other.index;
+        }
+    };
+
+    ProceduralPolyline(size_t numPoints, Generator generator) : count(numPoints), generator(std::move(generator)) {}
+
+    size_t size() const {
+        return count;
+    }
+
+    Point<T> operator[](size_t index) const {
+        if (index >= count) throw std::out_of_range("Index out of range");
+        return generator(index);
+    }
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, count);
+    }
+
+    double length() const {
+        return polylineLength(begin(), end());
+    }
+
+    double length(ParallelTag) const {
+        return lengthKernels::parallelLength(count, [this](size_t first, size_t points) {
+            return polylineLength(iterator(this, first), iterator(this, first + points));
+        });
+    }
+
+    //   : f     
+    template<typename F>
+    auto transformed(F f) const {
+        auto composed = [generator = generator, f = std::move(f)](size_t index) { return f(generator(index)); };
+        return ProceduralPolyline<T, decltype(composed)>(count, std::move(composed));
+    }
+
+    //      
+    Polyline<T> materialize() const {
+        Polyline<T> result(count, uninitialized);
+        Point<T>* out = result.data(); //         
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = generator(i);
+        }
+        return result;
+    }
+
+    template<typename Range>
+    bool operator==(const Range& other) const {
+        return polylinesEqual(begin(), end(), other.begin(), other.end(), Polyline<T>::epsilon);
+    }
+};
+
+template<typename Generator>
+ProceduralPolyline(size_t, Generator) -> ProceduralPolyline<decltype(std::declval<Generator>()(size_t()).x), Generator>;
+
+//    numPoints      
+template<typename T>
+ProceduralPolyline<T, RandomPointGenerator<T>> randomProceduralPolyline(size_t numPoints, T m1, T m2, std::uint64_t seed) {
+    return ProceduralPolyline<T, RandomPointGenerator<T>>(numPoints, RandomPointGenerator<T>{ m1, m2, seed });
+}
+
+//   :  64 ,  .
+//  AoS:   (x, y); SoA:  x,   y.
+//    64 ,      
+//      .   -  
+enum class PolylineLayout : std::uint32_t {
+    AoS = 0,
+    SoA = 1
+};
+
+struct PolylineFileHeader {
+    char magic[8]; // "POLYLINE"
+    std::uint32_t version; //  
+    std::uint32_t coordinateSize; // 4 - float, 8 - double
+    std::uint32_t layout; // PolylineLayout
+    std::uint32_t reserved;
+    std::uint64_t count; //  
+    std::uint64_t xOffset; //    (AoS)   x (SoA)
+    std::uint64_t yOffset; //   y (SoA)
+    char padding[16];
+};
+
+static_assert(sizeof(PolylineFileHeader) == 64, "Polyline file header must be 64 bytes");
+
+constexpr char polylineFileMagic[8] = { 'P', 'O', 'L', 'Y', 'L', 'I', 'N', 'E' };
+constexpr std::uint32_t polylineFileVersion = 1;
+constexpr std::uint64_t polylineFileAlignment = 64;
+
+//       
+class MappedFile {
+private:
+    const unsigned char* data = nullptr; //  
+    size_t size = 0; //  
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot read file size: " + path);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+        data = static_cast<const unsigned char*>(view);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot read file size: " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            ::close(fd);
+            return;
+        }
+        void* view = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); //      
+        if (view == MAP_FAILED) throw std::runtime_error("Cannot map file: " + path);
+        data = static_cast<const unsigned char*>(view);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) ::munmap(const_cast<unsigned char*>(data), size);
+#endif
+    }
+
+    const unsigned char* bytes() const {
+        return data;
+    }
+
+    size_t length() const {
+        return size;
+    }
+};
+
+// -    ( ,  ).
+//   i: xs[i * stride], ys[i * stride]; stride = 2 
+//    1  .    
+template<typename T>
+class PolylineView {
+private:
+    const T* xs = nullptr; //  
+    const T* ys = nullptr; //  
+    size_t count = 0; //  
+    size_t stride = 2; //    
+    std::shared_ptr<const MappedFile> mapping{}; //  ,     open()
+
+public:
+    class iterator {
+    private:
+        const PolylineView* owner = nullptr;
+        size_t index = 0;
+
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Point<T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = Point<T>;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(const PolylineView* owner, size_t index) : owner(owner), index(index) {}
+
+        Point<T> operator*() const {
+            return Point<T>(owner->xs[index * owner->stride], owner->ys[index * owner->stride]);
+        }
+
+        iterator& operator++() {
+            ++index;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++index;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const {
+            return index == other.index;
+        }
+    };
+
+    PolylineView() = default;
+    PolylineView(const PolylineView&) = default;
+    PolylineView(PolylineView&&) noexcept = default;
+    PolylineView& operator=(const PolylineView&) = default;
+    PolylineView& operator=(PolylineView&&) noexcept = default;
+
+    //   ; points   nullptr  numPoints = 0
+    PolylineView(const Point<T>* points, size_t numPoints)
+        : xs(reinterpret_cast<const T*>(points)), ys(points ? reinterpret_cast<const T*>(points) + 1 : nullptr), count(numPoints), stride(2) {
+        static_assert(sizeof(Point<T>) == 2 * sizeof(T), "Point<T> must be two packed coordinates");
+    }
+
+    //    
+    PolylineView(const T* x, const T* y, size_t numPoints) : xs(x), ys(y), count(numPoints), stride(1) {}
+
+    //  ,  writePolylineFile,   
+    static PolylineView open(const std::string& path) {
+        static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "Only float and double coordinates are supported");
+        auto file = std::make_shared<const MappedFile>(path);
+        PolylineFileHeader header;
+        if (file->length() < sizeof(header)) throw std::runtime_error("Not a polyline file: " + path);
+        std::memcpy(&header, file->bytes(), sizeof(header));
+        if (std::memcmp(header.magic, polylineFileMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Not a polyline file: " + path);
+        }
+        if (header.version != polylineFileVersion) throw std::runtime_error("Unsupported polyline file version: " + path);
+        if (header.coordinateSize != sizeof(T)) throw std::runtime_error("Polyline file coordinate type mismatch: " + path);
+
+        bool soa = header.layout == static_cast<std::uint32_t>(PolylineLayout::SoA);
+        if (!soa && header.layout != static_cast<std::uint32_t>(PolylineLayout::AoS)) {
+            throw std::runtime_error("Unknown polyline file layout: " + path);
+        }
+        std::uint64_t fileSize = file->length();
+        std::uint64_t arrayBytes = header.count * sizeof(T) * (soa ? 1 : 2);
+        if (header.count > fileSize / sizeof(T) ||
+            header.xOffset % alignof(T) != 0 || header.xOffset > fileSize || arrayBytes > fileSize - header.xOffset ||
+            (soa && (header.yOffset % alignof(T) != 0 || header.yOffset > fileSize || arrayBytes > fileSize - header.yOffset))) {
+            throw std::runtime_error("Corrupted polyline file: " + path);
+        }
+
+        PolylineView view;
+        const T* base = reinterpret_cast<const T*>(file->bytes() + header.xOffset);
+        view.count = static_cast<size_t>(header.count);
+        view.xs = base;
+        if (soa) {
+            view.ys = reinterpret_cast<const T*>(file->bytes() + header.yOffset);
+            view.stride = 1;
+        }
+        else {
+            view.ys = base + 1;
+            view.stride = 2;
+        }
+        view.mapping = std::move(file);
+        return view;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    PolylineLayout layout() const {
+        return stride == 2 ? PolylineLayout::AoS : PolylineLayout::SoA;
+    }
+
+    Point<T> operator[](size_t index) const {
+        if (index >= count) throw std::out_of_range("Index out of range");
+        return Point<T>(xs[index * stride], ys[index * stride]);
+    }
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, count);
+    }
+
+    //    points ,   first
+    double length(size_t first, size_t points) const {
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            if (stride == 2) return lengthKernels::interleaved(xs + 2 * first, points);
+            return lengthKernels::split(xs + first, ys + first, points);
+        }
+        else {
+            return polylineLength(iterator(this, first), iterator(this, first + points));
+        }
+    }
+
+    double length() const {
+        return length(0, count);
+    }
+
+    double length(ParallelTag) const {
+        if (count < Polyline<T>::parallelThreshold) return length();
+        return lengthKernels::parallelLength(count, [this](size_t first, size_t points) {
+            return length(first, points);
+        });
+    }
+
+    //    
+    Polyline<T> materialize() const {
+        Polyline<T> result(count, uninitialized);
+        Point<T>* out = result.data();
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = Point<T>(xs[i * stride], ys[i * stride]);
+        }
+        return result;
+    }
+
+    template<typename Range>
+    bool operator==(const Range& other) const {
+        return polylinesEqual(begin(), end(), other.begin(), other.end(), Polyline<T>::epsilon);
+    }
+};
+
+//      (. PolylineFileHeader)
+template<typename T, typename Allocator, size_t InlineCapacity>
+void writePolylineFile(const std::string& path, const Polyline<T, Allocator, InlineCapacity>& polyline, PolylineLayout layout = PolylineLayout::AoS) {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "Only float and double coordinates are supported");
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Cannot open file: " + path);
+
+    std::uint64_t count = polyline.size();
+    std::uint64_t arrayBytes = count * sizeof(T);
+    auto align = [](std::uint64_t offset) {
+        return (offset + polylineFileAlignment - 1) / polylineFileAlignment * polylineFileAlignment;
+    };
+
+    PolylineFileHeader header{};
+    std::memcpy(header.magic, polylineFileMagic, sizeof(header.magic));
+    header.version = polylineFileVersion;
+    header.coordinateSize = sizeof(T);
+    header.layout = static_cast<std::uint32_t>(layout);
+    header.count = count;
+    header.xOffset = sizeof(PolylineFileHeader);
+    header.yOffset = layout == PolylineLayout::SoA ? align(header.xOffset + arrayBytes) : 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (layout == PolylineLayout::AoS) {
+        out.write(reinterpret_cast<const char*>(polyline.begin()), static_cast<std::streamsize>(2 * arrayBytes));
+    }
+    else {
+        //        
+        constexpr size_t bufferPoints = 4096;
+        std::vector<T> buffer(bufferPoints);
+        const Point<T>* points = polyline.begin();
+        auto writeCoordinate = [&](T Point<T>::* coordinate) {
+            for (size_t first = 0; first < count; first += bufferPoints) {
+                size_t chunk = std::min<size_t>(bufferPoints, count - first);
+                for (size_t i = 0; i < chunk; ++i) {
+                    buffer[i] = points[first + i].*coordinate;
+                }
+                out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(chunk * sizeof(T)));
+            }
+        };
+        writeCoordinate(&Point<T>::x);
+        std::uint64_t padding = header.yOffset - header.xOffset - arrayBytes;
+        const char zeros[polylineFileAlignment] = {};
+        out.write(zeros, static_cast<std::streamsize>(padding));
+        writeCoordinate(&Point<T>::y);
+    }
+    if (!out) throw std::runtime_error("Cannot write file: " + path);
+}
+
+//        ( CSR):
+//   i  [offsets[i], offsets[i + 1]). 
+//   PolylineView  ;   
+//          .
+//      
+template<typename T>
+class PolylineCollection {
+private:
+    std::vector<Point<T>> vertices; //    
+    std::vector<size_t> offsets; // offsets[i] -    i, offsets.back() -   
+
+    //       parallelChunkSize :
+    // f(first, last)   [first, last)
+    template<typename F>
+    void forEachBlock(F f) const {
+        size_t total = vertices.size();
+        if (total < Polyline<T>::parallelThreshold) {
+            f(size_t(0), size());
+            return;
+        }
+        size_t blocks = (total + lengthKernels::parallelChunkSize - 1) / lengthKernels::parallelChunkSize;
+        //    ,   
+        auto firstPolyline = [&](size_t block) {
+            size_t vertex = std::min(block * lengthKernels::parallelChunkSize, total);
+            return static_cast<size_t>(std::lower_bound(offsets.begin(), offsets.end() - 1, vertex) - offsets.begin());
+        };
+        parallelFor(blocks, [&](size_t block) {
+            size_t first = firstPolyline(block);
+            size_t last = block + 1 == blocks ? size() : firstPolyline(block + 1);
+            if (first < last) f(first, last);
+        });
+    }
+
+public:
+    PolylineCollection() : vertices(), offsets(1, 0) {}
+
+    template<typename Range>
+    explicit PolylineCollection(const Range& polylines) : PolylineCollection() {
+        size_t total = 0;
+        for (const auto& polyline : polylines) {
+            total += static_cast<size_t>(std::distance(polyline.begin(), polyline.end()));
+        }
+        reserve(static_cast<size_t>(std::distance(std::begin(polylines), std::end(polylines))), total);
+        for (const auto& polyline : polylines) {
+            push_back(polyline.begin(), polyline.end());
+        }
+    }
+
+    //    numPolylines   numVertices  
+    void reserve(size_t numPolylines, size_t numVertices) {
+        offsets.reserve(numPolylines + 1);
+        vertices.reserve(numVertices);
+    }
+
+    //     [first, last)
+    template<typename It>
+    void push_back(It first, It last) {
+        vertices.insert(vertices.end(), first, last);
+        offsets.push_back(vertices.size());
+    }
+
+    template<typename Allocator, size_t InlineCapacity>
+    void push_back(const Polyline<T, Allocator, InlineCapacity>& polyline) {
+        push_back(polyline.begin(), polyline.end());
+    }
+
+    void push_back(const PolylineView<T>& polyline) {
+        push_back(polyline.begin(), polyline.end());
+    }
+
+    void clear() {
+        vertices.clear();
+        offsets.assign(1, 0);
+    }
+
+    //  
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t vertexCount() const {
+        return vertices.size();
+    }
+
+    //    index
+    size_t size(size_t index) const {
+        if (index >= size()) throw std::out_of_range("Index out of range");
+        return offsets[index + 1] - offsets[index];
+    }
+
+    //   index   
+    PolylineView<T> operator[](size_t index) const {
+        if (index >= size()) throw std::out_of_range("Index out of range");
+        return PolylineView<T>(vertices.data() + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+
+    //   index
+    Polyline<T> polyline(size_t index) const {
+        PolylineView<T> view = (*this)[index];
+        Polyline<T> result(size_t(0));
+        result.reserve(view.size());
+        for (Point<T> point : view) {
+            result.push_back(point);
+        }
+        return result;
+    }
+
+    std::span<const Point<T>> points() const {
+        return std::span<const Point<T>>(vertices);
+    }
+
+    std::span<const size_t> vertexOffsets() const {
+        return std::span<const size_t>(offsets);
+    }
+
+    //   : out[i] -   i
+    void lengths(std::span<double> out) const {
+        if (out.size() < size()) throw std::invalid_argument("Output span is too small");
+        forEachBlock([&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                out[i] = PolylineView<T>(vertices.data() + offsets[i], offsets[i + 1] - offsets[i]).length();
+            }
+        });
+    }
+
+    std::vector<double> lengths() const {
+        std::vector<double> out(size());
+        lengths(std::span<double>(out));
+        return out;
+    }
+
+    //     : point = f(point).
+    //      
+    template<typename F>
+    void transform(F f) {
+        size_t total = vertices.size();
+        size_t chunk = lengthKernels::parallelChunkSize;
+        size_t blocks = total < Polyline<T>::parallelThreshold ? 1 : (total + chunk - 1) / chunk;
+        if (blocks == 1) chunk = total;
+        Point<T>* data = vertices.data();
+        parallelFor(blocks, [&](size_t block) {
+            size_t first = block * chunk;
+            size_t last = std::min(first + chunk, total);
+            for (size_t i = first; i < last; ++i) {
+                data[i] = f(data[i]);
+            }
+        });
+    }
+
+    //      
+    void transform(const Affine2<T>& m) {
+        if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+            T* xy = reinterpret_cast<T*>(vertices.data());
+            if (vertices.size() >= Polyline<T>::parallelThreshold) {
+                affineKernels::transformParallel(xy, xy, vertices.size(), m);
+            }
+            else {
+                affineKernels::transform(xy, xy, vertices.size(), m);
+            }
+        }
+        else {
+            transform([&m](const Point<T>& point) { return m(point); });
+        }
+    }
+
+    template<typename F>
+    PolylineCollection transformed(F f) const {
+        PolylineCollection result(*this);
+        result.transform(std::move(f));
+        return result;
+    }
+
+    //    ,   pred(PolylineView<T>) .
+    //   ;   
+    template<typename Pred>
+    PolylineCollection filter(Pred pred) const {
+        std::vector<unsigned char> keep(size());
+        forEachBlock([&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                keep[i] = pred(PolylineView<T>(vertices.data() + offsets[i], offsets[i + 1] - offsets[i])) ? 1 : 0;
+            }
+        });
+        // target[i] -   i  
+        std::vector<size_t> target(size());
+        PolylineCollection result;
+        for (size_t i = 0; i < size(); ++i) {
+            target[i] = result.size();
+            if (keep[i]) result.offsets.push_back(result.offsets.back() + offsets[i + 1] - offsets[i]);
+        }
+        result.vertices.resize(result.offsets.back());
+        forEachBlock([&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                if (!keep[i]) continue;
+                std::copy(vertices.begin() + static_cast<std::ptrdiff_t>(offsets[i]),
+                          vertices.begin() + static_cast<std::ptrdiff_t>(offsets[i + 1]),
+                          result.vertices.begin() + static_cast<std::ptrdiff_t>(result.offsets[target[i]]));
+            }
+        });
+        return result;
+    }
+};
+
+//   :
+// Csv     -  "x,y" (    );
+// Wkt     - LINESTRING (x y, x y, ...)  LINESTRING EMPTY;
+// GeoJson -    "coordinates": [[x, y], ...]
+enum class TextFormat {
+    Csv,
+    Wkt,
+    GeoJson
+};
+
+namespace textIo {
+
+constexpr size_t blockSize = size_t(1) << 16; //     
+constexpr size_t maxNumberLength = 64; //     
+constexpr size_t maxTokenLength = 1024; //      
+
+//    ;   std::from_chars   
+class Scanner {
+private:
+    std::istream& in;
+    std::vector<char> buffer;
+    size_t pos = 0; //  
+    size_t end = 0; //   
+    bool finished = false; //  
+
+    // ,       need     
+    void require(size_t need) {
+        if (end - pos >= need || finished) return;
+        std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+        end -= pos;
+        pos = 0;
+        while (end < need && !finished) {
+            in.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+            std::streamsize got = in.gcount();
+            end += static_cast<size_t>(got);
+            if (got == 0) finished = true;
+        }
+    }
+
+public:
+    explicit Scanner(std::istream& in) : in(in), buffer(blockSize) {}
+
+    //    -1   
+    int peek() {
+        require(1);
+        return pos < end ? static_cast<unsigned char>(buffer[pos]) : -1;
+    }
+
+    void advance() {
+        ++pos;
+    }
+
+    //  ;  stopAtNewline    
+    void skipSpaces(bool stopAtNewline = false) {
+        for (int c = peek(); c == ' ' || c == '\t' || c == '\r' || (c == '\n' && !stopAtNewline); c = peek()) {
+            advance();
+        }
+    }
+
+    void skipLine() {
+        for (int c = peek(); c != -1; c = peek()) {
+            advance();
+            if (c == '\n') return;
+        }
+    }
+
+    [[noreturn]] void fail(const char* format, const std::string& message) const {
+        throw std::runtime_error(std::string("Invalid ") + format + ": " + message);
+    }
+
+    void expect(char c, const char* format) {
+        skipSpaces();
+        if (peek() != c) fail(format, std::string("expected '") + c + "'");
+        advance();
+    }
+
+    //     
+    bool keyword(const char* word) {
+        size_t length = std::strlen(word);
+        require(length);
+        if (end - pos < length) return false;
+        for (size_t i = 0; i < length; ++i) {
+            if (std::toupper(static_cast<unsigned char>(buffer[pos + i])) != word[i]) return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    //     text; false,   
+    bool find(const char* text) {
+        size_t length = std::strlen(text);
+        for (;;) {
+            require(length);
+            if (end - pos < length) return false;
+            if (std::memcmp(buffer.data() + pos, text, length) == 0) {
+                pos += length;
+                return true;
+            }
+            ++pos;
+        }
+    }
+
+    static bool isDelimiter(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == '(' || c == ')' ||
+               c == '[' || c == ']' || c == '{' || c == '}' || c == '"';
+    }
+
+    //  -     ;  ,
+    //     . ,   
+    // ,  
+    template<typename T>
+    bool number(T& value) {
+        skipSpaces();
+        size_t length = 0;
+        for (;;) {
+            while (pos + length < end && !isDelimiter(buffer[pos + length])) ++length;
+            if (pos + length < end || finished) break;
+            if (length > maxTokenLength) break;
+            require(length + 1);
+        }
+        if (length > maxTokenLength) {
+            throw std::runtime_error("Invalid number: longer than " + std::to_string(maxTokenLength) + " characters");
+        }
+        const char* first = buffer.data() + pos;
+        const char* last = first + length;
+        if (first < last && *first == '+') ++first;
+        auto result = std::from_chars(first, last, value);
+        if (result.ec != std::errc() || result.ptr != last) return false;
+        pos += length;
+        return true;
+    }
+};
+
+template<typename T, typename Allocator>
+Polyline<T, Allocator> readCsv(Scanner& scanner, const Allocator& allocator) {
+    Polyline<T, Allocator> result(size_t(0), allocator);
+    bool firstLine = true;
+    for (;;) {
+        scanner.skipSpaces();
+        int c = scanner.peek();
+        if (c == -1) break;
+        T x, y;
+        if (!scanner.number(x)) {
+            if (!firstLine) scanner.fail("CSV", "expected number");
+            scanner.skipLine(); // 
+            firstLine = false;
+            continue;
+        }
+        firstLine = false;
+        scanner.expect(',', "CSV");
+        if (!scanner.number(y)) scanner.fail("CSV", "expected number");
+        scanner.skipSpaces(true);
+        c = scanner.peek();
+        if (c != '\n' && c != -1) scanner.fail("CSV", "expected end of line");
+        result.push_back(Point<T>(x, y));
+    }
+    return result;
+}
+
+template<typename T, typename Allocator>
+Polyline<T, Allocator> readWkt(Scanner& scanner, const Allocator& allocator) {
+    Polyline<T, Allocator> result(size_t(0), allocator);
+    scanner.skipSpaces();
+    if (!scanner.keyword("LINESTRING")) scanner.fail("WKT", "expected LINESTRING");
+    scanner.skipSpaces();
+    if (scanner.keyword("EMPTY")) return result;
+    scanner.expect('(', "WKT");
+    for (;;) {
+        T x, y;
+        if (!scanner.number(x) || !scanner.number(y)) scanner.fail("WKT", "expected coordinate pair");
+        result.push_back(Point<T>(x, y));
+        scanner.skipSpaces();
+        int c = scanner.peek();
+        scanner.advance();
+        if (c == ')') break;
+        if (c != ',') scanner.fail("WKT", "expected ',' or ')'");
+    }
+    return result;
+}
+
+template<typename T, typename Allocator>
+Polyline<T, Allocator> readGeoJson(Scanner& scanner, const Allocator& allocator) {
+    Polyline<T, Allocator> result(size_t(0), allocator);
+    if (!scanner.find("\"coordinates\"")) scanner.fail("GeoJSON", "no \"coordinates\" member");
+    scanner.expect(':', "GeoJSON");
+    scanner.expect('[', "GeoJSON");
+    scanner.skipSpaces();
+    if (scanner.peek() == ']') {
+        scanner.advance();
+        return result;
+    }
+    for (;;) {
+        T x, y;
+        scanner.expect('[', "GeoJSON");
+        if (!scanner.number(x)) scanner.fail("GeoJSON", "expected number");
+        scanner.expect(',', "GeoJSON");
+        if (!scanner.number(y)) scanner.fail("GeoJSON", "expected number");
+        //     (  ..) 
+        scanner.skipSpaces();
+        while (scanner.peek() == ',') {
+            scanner.advance();
+            T ignored;
+            if (!scanner.number(ignored)) scanner.fail("GeoJSON", "expected number");
+            scanner.skipSpaces();
+        }
+        scanner.expect(']', "GeoJSON");
+        result.push_back(Point<T>(x, y));
+        scanner.skipSpaces();
+        int c = scanner.peek();
+        scanner.advance();
+        if (c == ']') break;
+        if (c != ',') scanner.fail("GeoJSON", "expected ',' or ']'");
+    }
+    return result;
+}
+
+//  :       
+//    ,      
+class Writer {
+private:
+    std::ostream& out;
+    std::vector<char> buffer;
+    size_t used = 0;
+
+public:
+    explicit Writer(std::ostream& out) : out(out), buffer(blockSize) {}
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer() {
+        flush();
+    }
+
+    void flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+    //       
+    void text(const char* str) {
+        size_t length = std::strlen(str);
+        if (length > buffer.size() - used) {
+            flush();
+            if (length > buffer.size()) {
+                out.write(str, static_cast<std::streamsize>(length));
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, str, length);
+        used += length;
+    }
+
+    template<typename T>
+    void number(T value) {
+        if (used + maxNumberLength > buffer.size()) flush();
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+        used = static_cast<size_t>(result.ptr - buffer.data());
+    }
+};
+
+} // namespace textIo
+
+//     
+template<typename T, typename Allocator = std::allocator<Point<T>>>
+Polyline<T, Allocator> readPolylineText(std::istream& in, TextFormat format, const Allocator& allocator = Allocator()) {
+    textIo::Scanner scanner(in);
+    switch (format) {
+    case TextFormat::Csv: return textIo::readCsv<T>(scanner, allocator);
+    case TextFormat::Wkt: return textIo::readWkt<T>(scanner, allocator);
+    case TextFormat::GeoJson: return textIo::readGeoJson<T>(scanner, allocator);
+    }
+    throw std::invalid_argument("Unknown text format");
+}
+
+//     ;     
+template<typename T, typename Allocator, size_t InlineCapacity>
+void writePolylineText(std::ostream& out, const Polyline<T, Allocator, InlineCapacity>& polyline, TextFormat format) {
+    textIo::Writer writer(out);
+    const Point<T>* first = polyline.begin();
+    const Point<T>* last = polyline.end();
+    switch (format) {
+    case TextFormat::Csv:
+        for (const Point<T>* p = first; p != last; ++p) {
+            writer.number(p->x);
+            writer.text(",");
+            writer.number(p->y);
+            writer.text("\n");
+        }
+        break;
+    case TextFormat::Wkt:
+        if (first == last) {
+            writer.text("LINESTRING EMPTY");
+            break;
+        }
+        writer.text("LINESTRING (");
+        for (const Point<T>* p = first; p != last; ++p) {
+            if (p != first) writer.text(", ");
+            writer.number(p->x);
+            writer.text(" ");
+            writer.number(p->y);
+        }
+        writer.text(")");
+        break;
+    case TextFormat::GeoJson:
+        writer.text("{\"type\":\"LineString\",\"coordinates\":[");
+        for (const Point<T>* p = first; p != last; ++p) {
+            if (p != first) writer.text(",");
+            writer.text("[");
+            writer.number(p->x);
+            writer.text(",");
+            writer.number(p->y);
+            writer.text("]");
+        }
+        writer.text("]}");
+        break;
+    }
+    writer.flush();
+    if (!out) throw std::runtime_error("Cannot write polyline text");
+}
+
+inline Polyline<double> createIsoscelesTriangle(double angle, double sideLength) {
+    if (angle <= 0 || angle >= 180) {
+        throw std::invalid_argument("Angle must be between 0 and PI");
+    }
+    if (sideLength <= 0) {
+        throw std::invalid_argument("Side length must be positive");
+    }
+
+    Polyline<double> triangle(3);
+
+    //  
+    triangle[0] = Point<double>(0, 0);
+    //  
+    triangle[1].x = sideLength * cos(angle / 2.0);
+    triangle[1].y = sideLength * sin(angle / 2.0);
+    //  
+    triangle[2].x = 2.0 * sideLength * cos(angle / 2.0);
+    triangle[2].y = 0.0;
+
+
+    return triangle;
+}
@@ -0,0 +1,1206 @@
+#include "polyline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//   . : lab1_tests ( ctest);
+//   0,    
+
+namespace {
+
+int failures = 0;
+
+// ,   NDEBUG   Release
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        ++failures;
+        std::cerr << "FAILED: " << what << '\n';
+    }
+}
+
+//        auto   
+void testConcatWithTemporaryPoint() {
+    Polyline<double> triangle = createIsoscelesTriangle(60.0, 2.0);
+    auto sum = triangle + Point<double>(1, 1);
+    auto reversed = Point<double>(1, 1) + triangle;
+    Polyline<double> expected = triangle;
+    expected.push_back(Point<double>(1, 1));
+    check(std::abs(sum.length() - expected.length()) < 1e-12, "auto sum = polyline + Point: length");
+    check(Polyline<double>(sum) == expected, "auto sum = polyline + Point: points");
+    check(Polyline<double>(reversed) == expected, "auto sum = Point + polyline: points");
+}
+
+//          
+void testRopeChunksStayLarge() {
+    using Rope = PolylineRope<double>;
+    std::mt19937_64 random(7);
+    Polyline<double> source(100000, 0.0, 1.0, std::uint64_t(3));
+    Rope rope(source);
+    std::vector<Point<double>> expected(source.begin(), source.end());
+    for (int i = 0; i < 50000; ++i) {
+        size_t index = random() % (expected.size() + 1);
+        Point<double> point(static_cast<double>(i), 0.0);
+        rope.insert(index, point);
+        expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(index), point);
+    }
+    check(rope.chunkCount() <= 2 * rope.size() / Rope::chunkCapacity + 1, "rope: chunk count after random inserts");
+
+    for (int i = 0; i < 2000; ++i) {
+        size_t first = random() % expected.size();
+        size_t last = std::min(expected.size(), first + random() % 64);
+        rope.erase(first, last);
+        expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(first), expected.begin() + static_cast<std::ptrdiff_t>(last));
+        if (i % 100 == 0) {
+            size_t index = random() % (expected.size() + 1);
+            Rope tail = rope.split(index);
+            rope += std::move(tail);
+        }
+    }
+    check(rope.chunkCount() <= 2 * rope.size() / Rope::chunkCapacity + 3, "rope: chunk count after random erases and splits");
+
+    Rope built;
+    for (int i = 0; i < 20000; ++i) {
+        built.insert(random() % (built.size() + 1), Point<double>(static_cast<double>(i), 1.0));
+    }
+    check(built.chunkCount() <= 2 * built.size() / Rope::chunkCapacity + 1, "rope: chunk count of a rope built by inserts");
+
+    bool same = rope.size() == expected.size();
+    for (size_t i = 0; same && i < expected.size(); ++i) {
+        same = rope[i].x == expected[i].x && rope[i].y == expected[i].y;
+    }
+    check(same, "rope: points after random edits");
+    Polyline<double> flat(expected.size(), uninitialized);
+    std::copy(expected.begin(), expected.end(), flat.begin());
+    check(std::abs(rope.length() - flat.length()) < 1e-6 * flat.length(), "rope: length after random edits");
+}
+
+//   [0, length()]   , NaN 
+void testPointAtOutOfRangeAndNan() {
+    Polyline<double> polyline(size_t(3));
+    polyline[0] = Point<double>(0, 0);
+    polyline[1] = Point<double>(1, 0);
+    polyline[2] = Point<double>(1, 1);
+    Point<double> before = polyline.pointAt(-1.0);
+    Point<double> after = polyline.pointAt(10.0);
+    Point<double> middle = polyline.pointAt(1.5);
+    check(before.x == 0 && before.y == 0, "pointAt: negative distance clamps to the start");
+    check(after.x == 1 && after.y == 1, "pointAt: distance past the end clamps to the end");
+    check(middle.x == 1 && std::abs(middle.y - 0.5) < 1e-12, "pointAt: distance inside the polyline");
+
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    bool thrown = false;
+    try {
+        polyline.pointAt(nan);
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    check(thrown, "pointAt: NaN distance is rejected");
+
+    const double distances[] = { 0.5, nan, 1.0 };
+    thrown = false;
+    try {
+        polyline.pointsAt(std::span<const double>(distances));
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    check(thrown, "pointsAt: NaN distance is rejected");
+}
+
+//  f(thread)    
+template<typename F>
+void runConcurrently(size_t threads, F f) {
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(f, t);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+//        
+//  ;     ,    
+void testConcurrentPointAt() {
+    const Polyline<double> polyline(100000, 0.0, 1.0, std::uint64_t(9));
+    Polyline<double> reference(polyline);
+    double length = reference.length();
+    std::vector<double> distances;
+    for (size_t i = 0; i <= 100; ++i) {
+        distances.push_back(length * static_cast<double>(i) / 100.0);
+    }
+    std::vector<Point<double>> expected = reference.pointsAt(std::span<const double>(distances));
+
+    std::atomic<size_t> mismatches{0};
+    runConcurrently(8, [&](size_t thread) {
+        for (size_t i = thread; i < distances.size(); i += 3) {
+            Point<double> point = polyline.pointAt(distances[i]);
+            if (point.x != expected[i].x || point.y != expected[i].y) ++mismatches;
+        }
+        std::vector<Point<double>> all = polyline.pointsAt(std::span<const double>(distances));
+        Polyline<double> resampled = polyline.resampleUniform(11);
+        if (all.size() != expected.size() || resampled.size() != 11) ++mismatches;
+    });
+    check(mismatches == 0, "pointAt: concurrent readers of a const polyline");
+}
+
+//       ; 
+//          
+void testConcurrentBounds() {
+    const Polyline<double> a(2000, 0.0, 1.0, std::uint64_t(10));
+    const Polyline<double> b(a);
+    const Polyline<double> c(200, 0.0, 1.0, std::uint64_t(11));
+    Bounds<double> expected = Polyline<double>(a).bounds();
+    size_t crossings = Polyline<double>(a).intersections(Polyline<double>(c)).size();
+
+    std::atomic<size_t> mismatches{0};
+    runConcurrently(8, [&](size_t) {
+        const Bounds<double>& box = a.bounds();
+        if (box.min.x != expected.min.x || box.min.y != expected.min.y || box.max.x != expected.max.x || box.max.y != expected.max.y) ++mismatches;
+        if (!(a == b) || a == c) ++mismatches;
+        if (a.intersections(c).size() != crossings) ++mismatches;
+    });
+    check(mismatches == 0, "bounds: concurrent readers of const polylines");
+}
+
+//         
+void testConcurrentDeduplicatorFind() {
+    PolylineDeduplicator<double> deduplicator;
+    std::vector<Polyline<double>> queries; //   
+    for (std::uint64_t seed = 0; seed < 64; ++seed) {
+        deduplicator.insert(Polyline<double>(100, 0.0, 1.0, seed));
+        queries.push_back(Polyline<double>(100, 0.0, 1.0, seed));
+        queries.push_back(Polyline<double>(100, 0.0, 1.0, seed + 1000));
+    }
+
+    const PolylineDeduplicator<double>& shared = deduplicator;
+    std::atomic<size_t> mismatches{0};
+    runConcurrently(8, [&](size_t) {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            size_t expected = i % 2 == 0 ? i / 2 : PolylineDeduplicator<double>::npos;
+            if (shared.find(queries[i]) != expected) ++mismatches;
+        }
+    });
+    check(mismatches == 0, "deduplicator: concurrent find with shared queries");
+}
+
+//       :    
+void testEmptyCollection() {
+    PolylineCollection<double> empty;
+    check(empty.lengths().empty(), "collection: lengths of an empty collection");
+    check(empty.filter([](const PolylineView<double>&) { return true; }).empty(), "collection: filter of an empty collection");
+    empty.transform(Affine2<double>::translation(1.0, 2.0));
+
+    PolylineCollection<double> blanks;
+    blanks.push_back(Polyline<double>(size_t(0)));
+    blanks.push_back(Polyline<double>(size_t(0)));
+    std::vector<double> lengths = blanks.lengths();
+    check(lengths.size() == 2 && lengths[0] == 0.0 && lengths[1] == 0.0, "collection: lengths of empty polylines");
+    check(blanks[1].size() == 0 && blanks.polyline(0).empty(), "collection: view of an empty polyline");
+    PolylineCollection<double> kept = blanks.filter([](const PolylineView<double>& view) { return view.size() == 0; });
+    check(kept.size() == 2 && kept.vertexCount() == 0, "collection: filter of empty polylines");
+}
+
+//        
+void testParallelExceptions() {
+    bool thrown = false;
+    try {
+        parallelFor(64, [](size_t task) {
+            if (task % 7 == 3) throw std::runtime_error("task failed");
+        });
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown, "parallelFor: exception is rethrown to the caller");
+
+    Polyline<double> empty(size_t(0));
+    SegmentIndex<double> index(empty);
+    std::vector<Point<double>> queries(5000, Point<double>(1, 1));
+    thrown = false;
+    try {
+        index.nearestPoints(std::span<const Point<double>>(queries));
+    }
+    catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    check(thrown, "SegmentIndex: batched query on an empty index throws");
+
+    size_t threshold = Polyline<double>::parallelThreshold;
+    Polyline<double>::parallelThreshold = 0;
+    PolylineCollection<double> collection;
+    collection.push_back(Polyline<double>(200000, 0.0, 1.0, std::uint64_t(12)));
+    thrown = false;
+    try {
+        collection.transform([](const Point<double>& point) -> Point<double> {
+            if (point.x > 0.999) throw std::domain_error("bad point");
+            return point;
+        });
+    }
+    catch (const std::domain_error&) {
+        thrown = true;
+    }
+    Polyline<double>::parallelThreshold = threshold;
+    check(thrown, "PolylineCollection: exception from a parallel transform is rethrown");
+}
+
+//        , 
+//  ;       
+void testTextLongTokens() {
+    std::string padding(textIo::blockSize - 10, ' ');
+    std::string longNumber = "0." + std::string(300, '0') + "15";
+    std::istringstream in(padding + "1," + longNumber + "\n2,3\n");
+    Polyline<double> polyline = readPolylineText<double>(in, TextFormat::Csv);
+    check(polyline.size() == 2 && polyline[0].x == 1.0 && polyline[0].y == 1.5e-301 && polyline[1].y == 3.0,
+          "text: number crossing a block boundary");
+
+    std::istringstream tooLong("1," + std::string(textIo::maxTokenLength + 10, '1') + "\n");
+    bool thrown = false;
+    try {
+        readPolylineText<double>(tooLong, TextFormat::Csv);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown, "text: over-long number is rejected");
+
+    std::ostringstream out;
+    std::string big(3 * textIo::blockSize, 'a');
+    {
+        textIo::Writer writer(out);
+        writer.text("[");
+        writer.text(big.c_str());
+        writer.number(1.5);
+        writer.text("]");
+    }
+    check(out.str() == "[" + big + "1.5]", "text: string longer than the write block");
+}
+
+//         
+void testMaterialize() {
+    auto procedural = randomProceduralPolyline<double>(1000, 0.0, 1.0, 5);
+    Polyline<double> points = procedural.materialize();
+    bool same = points.size() == procedural.size();
+    for (size_t i = 0; same && i < points.size(); ++i) {
+        same = points[i].x == procedural[i].x && points[i].y == procedural[i].y;
+    }
+    check(same, "ProceduralPolyline: materialize");
+    check(std::abs(points.length() - procedural.length()) < 1e-9, "ProceduralPolyline: length after materialize");
+
+    PolylineView<double> view(points.begin(), points.size());
+    check(view.materialize() == points, "PolylineView: materialize");
+}
+
+//   std::hypot  double -    
+template<typename T>
+double hypotLength(const std::vector<T>& xs, const std::vector<T>& ys) {
+    double total = 0.0;
+    for (size_t i = 1; i < xs.size(); ++i) {
+        total += std::hypot(static_cast<double>(xs[i]) - static_cast<double>(xs[i - 1]),
+                            static_cast<double>(ys[i]) - static_cast<double>(ys[i - 1]));
+    }
+    return total;
+}
+
+bool closeRelative(double actual, double expected, double tolerance) {
+    return std::abs(actual - expected) <= tolerance * std::max(1.0, std::abs(expected));
+}
+
+//     (   )   std::hypot
+template<typename T>
+void testSimdLength(const std::string& type, double tolerance) {
+    std::mt19937_64 random(11);
+    std::uniform_real_distribution<double> coordinate(-1000.0, 1000.0);
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n <= 40; ++n) sizes.push_back(n);
+    sizes.push_back(100003);
+    for (size_t n : sizes) {
+        std::vector<T> xs(n), ys(n), xy(2 * n);
+        Polyline<T> polyline(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = xy[2 * i] = static_cast<T>(coordinate(random));
+            ys[i] = xy[2 * i + 1] = static_cast<T>(coordinate(random));
+            polyline[i] = Point<T>(xs[i], ys[i]);
+        }
+        const double expected = hypotLength(xs, ys);
+        const std::string name = "simd length<" + type + ">, n = " + std::to_string(n);
+        check(closeRelative(lengthKernels::interleavedScalar(xy.data(), 0, n), expected, tolerance), name + ": interleaved scalar");
+        check(closeRelative(lengthKernels::splitScalar(xs.data(), ys.data(), 0, n), expected, tolerance), name + ": split scalar");
+#if POLYLINE_X86
+        if (lengthKernels::simdLevel() != lengthKernels::SimdLevel::Scalar) {
+            check(closeRelative(lengthKernels::interleavedSse2(xy.data(), n), expected, tolerance), name + ": interleaved sse2");
+            check(closeRelative(lengthKernels::splitSse2(xs.data(), ys.data(), n), expected, tolerance), name + ": split sse2");
+        }
+        if (lengthKernels::simdLevel() == lengthKernels::SimdLevel::Avx2) {
+            check(closeRelative(lengthKernels::interleavedAvx2(xy.data(), n), expected, tolerance), name + ": interleaved avx2");
+            check(closeRelative(lengthKernels::splitAvx2(xs.data(), ys.data(), n), expected, tolerance), name + ": split avx2");
+        }
+#endif
+        check(closeRelative(polyline.length(), expected, tolerance), name + ": Polyline::length");
+        check(closeRelative(polyline.length(LengthMode::Precise), expected, tolerance), name + ": Polyline::length(Precise)");
+        check(closeRelative(PolylineSoA<T>(polyline).length(), expected, tolerance), name + ": PolylineSoA::length");
+    }
+}
+
+//     ,    
+//      ,       
+void testParallelLength() {
+    const size_t savedThreshold = Polyline<double>::parallelThreshold;
+    Polyline<double>::parallelThreshold = 0;
+    const size_t chunk = lengthKernels::parallelChunkSize;
+    for (size_t n : {size_t(0), size_t(1), size_t(2), chunk, chunk + 1, chunk + 2, 3 * chunk + 5}) {
+        Polyline<double> polyline(n, -100.0, 100.0, std::uint64_t(n));
+        const std::string name = "parallel length, n = " + std::to_string(n);
+        const double serial = polyline.length();
+        const double concurrent = polyline.length(parallel);
+        check(closeRelative(concurrent, serial, 1e-12), name + ": Fast");
+        check(concurrent == polyline.length(parallel), name + ": repeated calls");
+        check(closeRelative(polyline.length(parallel, LengthMode::Precise), polyline.length(LengthMode::Precise), 1e-12), name + ": Precise");
+        PolylineSoA<double> soa(polyline);
+        check(closeRelative(soa.length(parallel), serial, 1e-12), name + ": PolylineSoA");
+    }
+    Polyline<double>::parallelThreshold = savedThreshold;
+}
+
+// Philox4x32-10:   Random123 ( 0,  0),
+//        
+//    
+void testPhilox() {
+    std::uint32_t words[4][1];
+    philox::generate<1>(0, 0, words);
+    check(words[0][0] == 0x6627e8d5u && words[1][0] == 0xe169c58du && words[2][0] == 0xbc57ac4cu && words[3][0] == 0x9b00dbd8u,
+          "philox: known-answer vector for counter 0, key 0");
+
+    const std::uint64_t first = 0xFFFFFFFCull; //      
+    const std::uint64_t key = 0x0123456789ABCDEFull;
+    std::uint32_t batch[4][philox::batch];
+    philox::generate<philox::batch>(first, key, batch);
+    bool sameBlocks = true;
+    for (size_t lane = 0; lane < philox::batch; ++lane) {
+        philox::generate<1>(first + lane, key, words);
+        for (size_t w = 0; w < 4; ++w) sameBlocks = sameBlocks && batch[w][lane] == words[w][0];
+    }
+    check(sameBlocks, "philox: batched blocks equal single blocks");
+
+    for (size_t n : {size_t(0), size_t(1), size_t(5), size_t(1) << 15, (size_t(1) << 16) + 3}) {
+        const std::string name = "philox points, n = " + std::to_string(n);
+        Polyline<double> serial(n, -5.0, 5.0, std::uint64_t(42));
+        Polyline<double> concurrent(n, -5.0, 5.0, std::uint64_t(42), parallel);
+        check(std::equal(serial.begin(), serial.end(), concurrent.begin(), concurrent.end(), [](const Point<double>& a, const Point<double>& b) {
+            return a.x == b.x && a.y == b.y;
+        }), name + ": serial and parallel double");
+        Polyline<float> serialFloat(n, -5.0f, 5.0f, std::uint64_t(42));
+        Polyline<float> concurrentFloat(n, -5.0f, 5.0f, std::uint64_t(42), parallel);
+        check(std::equal(serialFloat.begin(), serialFloat.end(), concurrentFloat.begin(), concurrentFloat.end(), [](const Point<float>& a, const Point<float>& b) {
+            return a.x == b.x && a.y == b.y;
+        }), name + ": serial and parallel float");
+        bool inRange = true;
+        bool samePoints = true;
+        for (size_t i = 0; i < n; ++i) {
+            inRange = inRange && serial[i].x >= -5.0 && serial[i].x < 5.0 && serial[i].y >= -5.0 && serial[i].y < 5.0;
+            if (i % 997 == 0 || i + 1 == n) {
+                Point<double> p = philox::uniformPoint(i, -5.0, 5.0, std::uint64_t(42));
+                Point<float> q = philox::uniformPoint(i, -5.0f, 5.0f, std::uint64_t(42));
+                samePoints = samePoints && p.x == serial[i].x && p.y == serial[i].y && q.x == serialFloat[i].x && q.y == serialFloat[i].y;
+            }
+        }
+        check(inRange, name + ": coordinates in [m1, m2)");
+        check(samePoints, name + ": uniformPoint matches the polyline");
+    }
+    Polyline<double> other(16, -5.0, 5.0, std::uint64_t(43));
+    check(!(other == Polyline<double>(16, -5.0, 5.0, std::uint64_t(42))), "philox: different seeds give different points");
+}
+
+//          
+//       
+template<typename T>
+void testBinaryRoundTrip(const std::string& type) {
+    const std::string path = (std::filesystem::temp_directory_path() / ("lab1_tests_" + type + ".polyline")).string();
+    for (PolylineLayout layout : {PolylineLayout::AoS, PolylineLayout::SoA}) {
+        for (size_t n : {size_t(0), size_t(1), size_t(1001)}) {
+            const std::string name = "binary round trip<" + type + ">, " + (layout == PolylineLayout::AoS ? "AoS" : "SoA") + ", n = " + std::to_string(n);
+            Polyline<T> polyline(n, T(-1e6), T(1e6), std::uint64_t(n + 1));
+            writePolylineFile(path, polyline, layout);
+            PolylineView<T> view = PolylineView<T>::open(path);
+            check(view.size() == n && view.layout() == layout, name + ": header");
+            bool same = true;
+            for (size_t i = 0; same && i < n; ++i) {
+                same = view[i].x == polyline[i].x && view[i].y == polyline[i].y;
+            }
+            check(same, name + ": points");
+            check(view.materialize() == polyline, name + ": materialize");
+            check(closeRelative(view.length(), polyline.length(), 1e-12), name + ": length");
+        }
+    }
+
+    bool rejected = false;
+    try {
+        if constexpr (std::is_same_v<T, float>) PolylineView<double>::open(path);
+        else PolylineView<float>::open(path);
+    }
+    catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "binary round trip<" + type + ">: other coordinate type is rejected");
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "POLYLINE";
+    rejected = false;
+    try {
+        PolylineView<T>::open(path);
+    }
+    catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "binary round trip<" + type + ">: truncated file is rejected");
+    std::filesystem::remove(path);
+}
+
+//   CSV, WKT  GeoJSON       
+// ;   ,  
+template<typename T>
+void testTextRoundTrip(const std::string& type) {
+    const std::pair<TextFormat, std::string> formats[] = {
+        { TextFormat::Csv, "CSV" }, { TextFormat::Wkt, "WKT" }, { TextFormat::GeoJson, "GeoJSON" }
+    };
+    for (const auto& [format, formatName] : formats) {
+        for (size_t n : {size_t(0), size_t(1), size_t(5000)}) {
+            const std::string name = "text round trip<" + type + ">, " + formatName + ", n = " + std::to_string(n);
+            Polyline<T> polyline(n, T(-1e5), T(1e5), std::uint64_t(n + 7));
+            if (n > 0) polyline[0] = Point<T>(std::numeric_limits<T>::denorm_min(), -std::numeric_limits<T>::max());
+            std::ostringstream out;
+            writePolylineText(out, polyline, format);
+            std::istringstream in(out.str());
+            Polyline<T> read = readPolylineText<T>(in, format);
+            bool same = read.size() == n;
+            for (size_t i = 0; same && i < n; ++i) {
+                same = read[i].x == polyline[i].x && read[i].y == polyline[i].y;
+            }
+            check(same, name);
+        }
+    }
+
+    const std::pair<TextFormat, std::string> handWritten[] = {
+        { TextFormat::Csv, "x,y\n1.5,-2\r\n3e2, 4\n" },
+        { TextFormat::Wkt, "  LINESTRING( 1.5 -2 ,3e2   4 )" },
+        { TextFormat::GeoJson, "{ \"type\": \"LineString\", \"coordinates\": [ [1.5, -2, 10], [ 3e2 , 4 ] ] }" }
+    };
+    for (const auto& [format, text] : handWritten) {
+        std::istringstream in(text);
+        Polyline<T> read = readPolylineText<T>(in, format);
+        check(read.size() == 2 && read[0].x == T(1.5) && read[0].y == T(-2) && read[1].x == T(300) && read[1].y == T(4),
+              "text<" + type + ">: parse \"" + text + "\"");
+    }
+
+    const std::pair<TextFormat, std::string> malformed[] = {
+        { TextFormat::Csv, "1,2\n3;4\n" },
+        { TextFormat::Wkt, "LINESTRING (1 2, 3)" },
+        { TextFormat::GeoJson, "{\"coordinates\":[[1,2],[3,x]]}" }
+    };
+    for (const auto& [format, text] : malformed) {
+        std::istringstream in(text);
+        bool thrown = false;
+        try {
+            readPolylineText<T>(in, format);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        check(thrown, "text<" + type + ">: reject \"" + text + "\"");
+    }
+}
+
+// ,    
+size_t liveAllocations = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++liveAllocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        --liveAllocations;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    bool operator==(const CountingAllocator&) const {
+        return true;
+    }
+};
+
+//     ,     InlineCapacity;
+//            
+void testSmallBuffer() {
+    using Small = Polyline<double, CountingAllocator<Point<double>>, 4>;
+    auto storedInside = [](const Small& polyline) {
+        const void* object = &polyline;
+        const void* data = polyline.begin();
+        return data >= object && data < static_cast<const void*>(&polyline + 1);
+    };
+    auto sequential = [](const Small& polyline, size_t n) {
+        bool same = polyline.size() == n;
+        for (size_t i = 0; same && i < n; ++i) {
+            same = polyline[i].x == static_cast<double>(i) && polyline[i].y == -static_cast<double>(i);
+        }
+        return same;
+    };
+    {
+        Small polyline(size_t(0));
+        for (size_t i = 0; i < 4; ++i) polyline.push_back(Point<double>(static_cast<double>(i), -static_cast<double>(i)));
+        check(liveAllocations == 0 && polyline.capacity() == 4 && storedInside(polyline), "small buffer: four points stay inline");
+
+        Small copy = polyline;
+        Small moved = std::move(copy);
+        check(liveAllocations == 0 && storedInside(moved) && sequential(moved, 4), "small buffer: inline copy and move");
+
+        polyline.push_back(Point<double>(4.0, -4.0));
+        check(liveAllocations == 1 && polyline.capacity() >= 5 && !storedInside(polyline) && sequential(polyline, 5),
+              "small buffer: fifth point moves to the heap");
+
+        Small stolen = std::move(polyline);
+        check(liveAllocations == 1 && sequential(stolen, 5), "small buffer: heap move takes the buffer");
+
+        stolen.swap(moved);
+        check(storedInside(stolen) && sequential(stolen, 4) && !storedInside(moved) && sequential(moved, 5),
+              "small buffer: swap of inline and heap polylines");
+
+        stolen.reserve(100);
+        check(liveAllocations == 2 && !storedInside(stolen) && sequential(stolen, 4), "small buffer: reserve leaves the buffer");
+        stolen.shrink_to_fit();
+        check(liveAllocations == 1 && storedInside(stolen) && sequential(stolen, 4), "small buffer: shrink_to_fit returns inline");
+
+        moved = stolen;
+        check(liveAllocations == 0 && storedInside(moved) && sequential(moved, 4), "small buffer: assigning a small polyline");
+    }
+    check(liveAllocations == 0, "small buffer: no leaked allocations");
+
+    {
+        Polyline<double, CountingAllocator<Point<double>>, 0> heapOnly(size_t(0));
+        heapOnly.push_back(Point<double>(1.0, 2.0));
+        check(liveAllocations == 1, "small buffer: InlineCapacity 0 always allocates");
+    }
+    check(liveAllocations == 0, "small buffer: InlineCapacity 0 frees its buffer");
+}
+
+//   ,       ; 
+//   ,      
+void testCopyOnWrite() {
+    CowPolyline<double> original(100, 0.0, 1.0, std::uint64_t(9));
+    const Polyline<double> before = original.toPolyline();
+    CowPolyline<double> first = original;
+    CowPolyline<double> second = first;
+    check(original.useCount() == 3 && first.begin() == original.begin(), "COW: copies share the buffer");
+
+    const CowPolyline<double>& reader = second;
+    check(reader[5].x == before[5].x && second.useCount() == 3, "COW: const access does not detach");
+
+    second[5] = Point<double>(-1.0, -1.0);
+    check(second.useCount() == 1 && original.useCount() == 2 && second.begin() != original.begin(), "COW: write detaches the writer");
+    check(original.toPolyline() == before && first.toPolyline() == before, "COW: other owners keep their points");
+    check(second[5].x == -1.0 && second.size() == 100, "COW: writer sees its change");
+
+    const Point<double>* buffer = second.begin();
+    second[6] = Point<double>(-2.0, -2.0);
+    check(second.begin() == buffer, "COW: unique owner writes in place");
+
+    first.push_back(Point<double>(2.0, 2.0));
+    check(first.size() == 101 && original.size() == 100 && original.useCount() == 1, "COW: push_back detaches");
+
+    CowPolyline<double> self = original;
+    original += original;
+    check(original.size() == 200 && self.toPolyline() == before, "COW: appending to itself while shared");
+
+    CowPolyline<double> moved = std::move(self);
+    check(moved.useCount() == 1 && self.useCount() == 0 && self.size() == 0, "COW: move leaves the source empty");
+    self.push_back(Point<double>(1.0, 1.0));
+    check(self.size() == 1, "COW: moved-from polyline is usable");
+
+    std::atomic<int> mismatches{ 0 };
+    const CowPolyline<double> source(1000, 0.0, 1.0, std::uint64_t(10));
+    runConcurrently(4, [&source, &mismatches](size_t thread) {
+        const double marker = 2.0 + static_cast<double>(thread); //  [0, 1)
+        for (size_t i = 0; i < 100; ++i) {
+            CowPolyline<double> local = source;
+            local[i] = Point<double>(marker, 0.0);
+            if (local[i].x != marker || source[i].x == marker) ++mismatches;
+        }
+    });
+    check(mismatches == 0 && source.useCount() == 1, "COW: concurrent copies detach independently");
+}
+
+//       :  
+//        
+void testRopeEdits() {
+    using Rope = PolylineRope<double>;
+    std::mt19937_64 random(21);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    auto randomPoint = [&] { return Point<double>(coordinate(random), coordinate(random)); };
+    auto modelLength = [](const std::vector<Point<double>>& points) {
+        double total = 0.0;
+        for (size_t i = 1; i < points.size(); ++i) {
+            total += std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+        }
+        return total;
+    };
+    auto matches = [&](const Rope& rope, const std::vector<Point<double>>& model) {
+        Polyline<double> flat = rope.toPolyline();
+        bool same = rope.size() == model.size() && flat.size() == model.size();
+        for (size_t i = 0; same && i < model.size(); ++i) {
+            same = rope[i].x == model[i].x && rope[i].y == model[i].y && flat[i].x == model[i].x && flat[i].y == model[i].y;
+        }
+        return same && closeRelative(rope.length(), modelLength(model), 1e-9);
+    };
+
+    Rope rope;
+    std::vector<Point<double>> model;
+    bool consistent = matches(rope, model);
+    for (int step = 0; consistent && step < 1000; ++step) {
+        size_t index = random() % (model.size() + 1);
+        switch (random() % 6) {
+        case 0: {
+            Point<double> point = randomPoint();
+            rope.insert(index, point);
+            model.insert(model.begin() + static_cast<std::ptrdiff_t>(index), point);
+            break;
+        }
+        case 1: {
+            std::vector<Point<double>> block(random() % (Rope::chunkCapacity + 100));
+            Polyline<double> source(block.size(), uninitialized);
+            for (size_t i = 0; i < block.size(); ++i) source[i] = block[i] = randomPoint();
+            rope.insert(index, Rope(source));
+            model.insert(model.begin() + static_cast<std::ptrdiff_t>(index), block.begin(), block.end());
+            break;
+        }
+        case 2: {
+            size_t last = std::min(model.size(), index + random() % (Rope::chunkCapacity + 10));
+            rope.erase(index, last);
+            model.erase(model.begin() + static_cast<std::ptrdiff_t>(index), model.begin() + static_cast<std::ptrdiff_t>(last));
+            break;
+        }
+        case 3:
+            if (index < model.size()) {
+                Point<double> point = randomPoint();
+                rope.set(index, point);
+                model[index] = point;
+            }
+            break;
+        case 4: {
+            Rope tail = rope.split(index);
+            consistent = matches(tail, std::vector<Point<double>>(model.begin() + static_cast<std::ptrdiff_t>(index), model.end()));
+            rope = rope + tail;
+            break;
+        }
+        default:
+            rope.push_back(model.emplace_back(randomPoint()));
+            break;
+        }
+        //      ,  - 
+        consistent = consistent && (step % 50 == 0 ? matches(rope, model) : closeRelative(rope.length(), modelLength(model), 1e-9));
+    }
+    consistent = consistent && matches(rope, model);
+    check(consistent, "rope: random edits match a vector model");
+
+    Rope copy = rope;
+    copy.erase(0, copy.size() / 2);
+    check(matches(rope, model), "rope: copy is independent of the original");
+    Rope doubled = rope + rope;
+    std::vector<Point<double>> twice = model;
+    twice.insert(twice.end(), model.begin(), model.end());
+    check(matches(doubled, twice), "rope: concatenation with itself");
+}
+
+// ,       epsilon, ,
+//        ;  
+// epsilon      .   
+//    operator==
+void testDeduplicatorNearDuplicates() {
+    const double epsilon = Polyline<double>::epsilon;
+    const double step = 3.0 * epsilon; //   
+    std::mt19937_64 random(33);
+    std::uniform_real_distribution<double> shift(-0.4 * epsilon, 0.4 * epsilon);
+
+    PolylineDeduplicator<double> deduplicator;
+    std::vector<Polyline<double>> originals;
+    for (std::uint64_t seed = 0; seed < 200; ++seed) {
+        Polyline<double> polyline(1 + seed % 7, 0.0, 1.0, seed);
+        //    0.1 epsilon   
+        Point<double>& first = polyline[0];
+        Point<double>& last = polyline[polyline.size() - 1];
+        first.x = std::floor(first.x / step) * step + 0.1 * epsilon;
+        last.y = std::ceil(last.y / step) * step - 0.1 * epsilon;
+        check(deduplicator.insert(polyline) == originals.size(), "deduplicator: distinct polylines are kept");
+        originals.push_back(polyline);
+    }
+
+    auto bruteForce = [&](const Polyline<double>& query) {
+        for (size_t i = 0; i < originals.size(); ++i) {
+            if (originals[i] == query) return i;
+        }
+        return PolylineDeduplicator<double>::npos;
+    };
+    size_t mismatches = 0;
+    size_t found = 0;
+    for (size_t i = 0; i < originals.size(); ++i) {
+        Polyline<double> near = originals[i];
+        for (Point<double>& point : near) {
+            point.x += shift(random);
+            point.y += shift(random);
+        }
+        //     ;     epsilon
+        near[0].x -= 0.5 * epsilon;
+        near[near.size() - 1].y += 0.5 * epsilon;
+
+        Polyline<double> far = originals[i];
+        far[far.size() / 2].y += 2.0 * epsilon;
+
+        for (const Polyline<double>* query : { &originals[i], &near, &far }) {
+            size_t expected = bruteForce(*query);
+            if (deduplicator.find(*query) != expected) ++mismatches;
+            if (expected != PolylineDeduplicator<double>::npos) ++found;
+        }
+        if (deduplicator.insert(near) != i) ++mismatches;
+    }
+    check(mismatches == 0, "deduplicator: find matches brute force");
+    check(found == 2 * originals.size(), "deduplicator: exact and near copies are duplicates, far ones are not");
+    check(deduplicator.size() == originals.size(), "deduplicator: near duplicates are not added");
+}
+
+//          
+// ,    x' = a x + b y + tx  double.   FMA
+//  AVX2   float:    
+template<typename T>
+void testAffineTransform(const std::string& type, double tolerance) {
+    const Affine2<T> m = Affine2<T>::rotation(0.7, Point<T>(T(3), T(-2))) * Affine2<T>::scaling(T(1.5), T(-0.25)) * Affine2<T>::translation(T(10), T(20));
+    auto close = [&](const Point<T>& actual, const Point<T>& source) {
+        double x = static_cast<double>(source.x);
+        double y = static_cast<double>(source.y);
+        double ax = static_cast<double>(m.a) * x, bx = static_cast<double>(m.b) * y;
+        double cy = static_cast<double>(m.c) * x, dy = static_cast<double>(m.d) * y;
+        double expectedX = ax + bx + static_cast<double>(m.tx);
+        double expectedY = cy + dy + static_cast<double>(m.ty);
+        double scaleX = std::abs(ax) + std::abs(bx) + std::abs(static_cast<double>(m.tx));
+        double scaleY = std::abs(cy) + std::abs(dy) + std::abs(static_cast<double>(m.ty));
+        return std::abs(static_cast<double>(actual.x) - expectedX) <= tolerance * scaleX &&
+               std::abs(static_cast<double>(actual.y) - expectedY) <= tolerance * scaleY;
+    };
+    auto allClose = [&](const Polyline<T>& actual, const Polyline<T>& source) {
+        bool same = actual.size() == source.size();
+        for (size_t i = 0; same && i < source.size(); ++i) same = close(actual[i], source[i]);
+        return same;
+    };
+
+    const size_t savedThreshold = Polyline<T>::parallelThreshold;
+    Polyline<T>::parallelThreshold = 0;
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n <= 20; ++n) sizes.push_back(n);
+    sizes.push_back(lengthKernels::parallelChunkSize + 3);
+    for (size_t n : sizes) {
+        const std::string name = "affine<" + type + ">, n = " + std::to_string(n);
+        const Polyline<T> source(n, T(-100), T(100), std::uint64_t(n + 3));
+        const T* in = reinterpret_cast<const T*>(source.begin());
+        std::vector<T> out(2 * n);
+        auto kernelClose = [&] {
+            bool same = true;
+            for (size_t i = 0; same && i < n; ++i) same = close(Point<T>(out[2 * i], out[2 * i + 1]), source[i]);
+            return same;
+        };
+        affineKernels::transformScalar(in, out.data(), 0, n, m);
+        check(kernelClose(), name + ": scalar kernel");
+#if POLYLINE_X86
+        if (lengthKernels::simdLevel() != lengthKernels::SimdLevel::Scalar) {
+            affineKernels::transformSse2(in, out.data(), n, m);
+            check(kernelClose(), name + ": sse2 kernel");
+        }
+        if (lengthKernels::simdLevel() == lengthKernels::SimdLevel::Avx2) {
+            affineKernels::transformAvx2(in, out.data(), n, m);
+            check(kernelClose(), name + ": avx2 kernel");
+        }
+#endif
+        check(allClose(source.transformed(m), source), name + ": transformed");
+        check(allClose(source.transformed(m, parallel), source), name + ": transformed(parallel)");
+        Polyline<T> inPlace = source;
+        inPlace.transform(m, parallel);
+        check(allClose(inPlace, source), name + ": transform(parallel) in place");
+
+        PolylineCollection<T> collection;
+        collection.push_back(source);
+        collection.push_back(source);
+        collection.transform(m);
+        check(allClose(collection.polyline(1), source), name + ": PolylineCollection::transform");
+    }
+    Polyline<T>::parallelThreshold = savedThreshold;
+
+    Polyline<T> moved(size_t(1));
+    moved[0] = Point<T>(T(1), T(0));
+    moved.rotate(std::acos(-1.0) / 2).scale(T(2), T(3)).translate(T(-1), T(1));
+    check(std::abs(moved[0].x + T(1)) < T(1e-5) && std::abs(moved[0].y - T(4)) < T(1e-5), "affine<" + type + ">: rotate, scale and translate");
+}
+
+//        
+//   (NaN );    ,
+//        
+template<typename T>
+void testBoundsAndHull(const std::string& type) {
+    std::mt19937_64 random(44);
+    std::uniform_real_distribution<double> coordinate(-50.0, 50.0);
+    auto same = [](const Bounds<T>& a, const Bounds<T>& b) {
+        return a.empty() == b.empty() && (a.empty() || (a.min.x == b.min.x && a.min.y == b.min.y && a.max.x == b.max.x && a.max.y == b.max.y));
+    };
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n <= 20; ++n) sizes.push_back(n);
+    sizes.push_back(10007);
+    for (size_t n : sizes) {
+        const std::string name = "bounds<" + type + ">, n = " + std::to_string(n);
+        std::vector<T> xy(2 * n);
+        Bounds<T> expected;
+        for (size_t i = 0; i < n; ++i) {
+            xy[2 * i] = static_cast<T>(coordinate(random));
+            xy[2 * i + 1] = static_cast<T>(coordinate(random));
+            if (i % 5 == 3) xy[2 * i + i % 2] = std::numeric_limits<T>::quiet_NaN();
+            if (!std::isnan(xy[2 * i])) {
+                expected.min.x = std::min(expected.min.x, xy[2 * i]);
+                expected.max.x = std::max(expected.max.x, xy[2 * i]);
+            }
+            if (!std::isnan(xy[2 * i + 1])) {
+                expected.min.y = std::min(expected.min.y, xy[2 * i + 1]);
+                expected.max.y = std::max(expected.max.y, xy[2 * i + 1]);
+            }
+        }
+        Bounds<T> scalar;
+        boundsKernels::interleavedScalar(xy.data(), 0, n, scalar);
+        check(same(scalar, expected), name + ": scalar kernel");
+#if POLYLINE_X86
+        if (lengthKernels::simdLevel() != lengthKernels::SimdLevel::Scalar) {
+            check(same(boundsKernels::interleavedSse2(xy.data(), n), expected), name + ": sse2 kernel");
+        }
+        if (lengthKernels::simdLevel() == lengthKernels::SimdLevel::Avx2) {
+            check(same(boundsKernels::interleavedAvx2(xy.data(), n), expected), name + ": avx2 kernel");
+        }
+#endif
+        check(same(boundsKernels::interleaved(xy.data(), n), expected), name + ": dispatched kernel");
+    }
+
+    Polyline<T> polyline(1000, T(-1), T(1), std::uint64_t(45));
+    auto scanned = [](const Polyline<T>& p) {
+        Bounds<T> result;
+        for (const Point<T>& point : p) result.expand(point);
+        return result;
+    };
+    check(same(polyline.bounds(), scanned(polyline)), "bounds<" + type + ">: polyline");
+    polyline.push_back(Point<T>(T(5), T(-7)));
+    check(same(polyline.bounds(), scanned(polyline)), "bounds<" + type + ">: cache expands on push_back");
+    polyline += Polyline<T>(Point<T>(T(-9), T(8)));
+    check(same(polyline.bounds(), scanned(polyline)), "bounds<" + type + ">: cache expands on append");
+    polyline.scale(T(0.5), T(0.5));
+    check(same(polyline.bounds(), scanned(polyline)), "bounds<" + type + ">: cache is reset by transform");
+    polyline[0] = Point<T>(T(100), T(100));
+    check(same(polyline.bounds(), scanned(polyline)), "bounds<" + type + ">: cache is reset by write access");
+
+    //     :       
+    auto cross = [](const Point<T>& o, const Point<T>& a, const Point<T>& b) {
+        return static_cast<double>(a.x - o.x) * static_cast<double>(b.y - o.y) -
+               static_cast<double>(a.y - o.y) * static_cast<double>(b.x - o.x);
+    };
+    const size_t savedThreshold = Polyline<T>::parallelThreshold;
+    for (size_t n : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(10), size_t(100), size_t(5000)}) {
+        const std::string name = "convex hull<" + type + ">, n = " + std::to_string(n);
+        Polyline<T> cloud(n);
+        for (Point<T>& point : cloud) point = Point<T>(static_cast<T>(random() % 21), static_cast<T>(random() % 21));
+        Polyline<T> hull = cloud.convexHull();
+        const size_t h = hull.size();
+        bool fromInput = true;
+        for (const Point<T>& vertex : hull) {
+            fromInput = fromInput && std::any_of(cloud.begin(), cloud.end(), [&](const Point<T>& p) { return p.x == vertex.x && p.y == vertex.y; });
+        }
+        bool convex = true;
+        bool containsAll = true;
+        if (h >= 3) {
+            for (size_t i = 0; i < h; ++i) {
+                const Point<T>& a = hull[i];
+                const Point<T>& b = hull[(i + 1) % h];
+                convex = convex && cross(a, b, hull[(i + 2) % h]) > 0;
+                for (const Point<T>& p : cloud) containsAll = containsAll && cross(a, b, p) >= 0;
+            }
+        }
+        bool startsLeftmost = h == 0 || std::all_of(cloud.begin(), cloud.end(), [&](const Point<T>& p) {
+            return p.x > hull[0].x || (p.x == hull[0].x && p.y >= hull[0].y);
+        });
+        check(fromInput, name + ": vertices are input points");
+        check(convex, name + ": strictly convex, counterclockwise");
+        check(containsAll, name + ": contains every point");
+        check(startsLeftmost, name + ": starts at the lowest leftmost point");
+        Polyline<T>::parallelThreshold = 0;
+        check(cloud.convexHull(parallel) == hull, name + ": parallel sort gives the same hull");
+        Polyline<T>::parallelThreshold = savedThreshold;
+    }
+}
+
+//    ab :    
+//    . ,     SegmentIndex
+template<typename T>
+bool segmentTouchesRect(const Point<T>& a, const Point<T>& b, const Bounds<T>& rect) {
+    if (rect.contains(a) || rect.contains(b)) return true;
+    auto orientation = [](const Point<double>& o, const Point<double>& p, const Point<double>& q) {
+        double value = (p.x - o.x) * (q.y - o.y) - (p.y - o.y) * (q.x - o.x);
+        return (value > 0) - (value < 0);
+    };
+    auto crosses = [&](const Point<double>& p1, const Point<double>& p2, const Point<double>& q1, const Point<double>& q2) {
+        return orientation(p1, p2, q1) * orientation(p1, p2, q2) <= 0 && orientation(q1, q2, p1) * orientation(q1, q2, p2) <= 0;
+    };
+    Point<double> p(static_cast<double>(a.x), static_cast<double>(a.y));
+    Point<double> q(static_cast<double>(b.x), static_cast<double>(b.y));
+    Point<double> corners[4] = {
+        { static_cast<double>(rect.min.x), static_cast<double>(rect.min.y) }, { static_cast<double>(rect.max.x), static_cast<double>(rect.min.y) },
+        { static_cast<double>(rect.max.x), static_cast<double>(rect.max.y) }, { static_cast<double>(rect.min.x), static_cast<double>(rect.max.y) }
+    };
+    for (int side = 0; side < 4; ++side) {
+        if (crosses(p, q, corners[side], corners[(side + 1) % 4])) return true;
+    }
+    return false;
+}
+
+//        R- 
+//    ,      
+template<typename T>
+void testSegmentIndex(const std::string& type) {
+    std::mt19937_64 random(55);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    std::uniform_real_distribution<double> place(-30.0, 30.0);
+    std::uniform_real_distribution<double> extent(0.0, 8.0);
+    for (size_t n : {size_t(1), size_t(2), size_t(3), size_t(17), size_t(5000)}) {
+        const std::string name = "segment index<" + type + ">, n = " + std::to_string(n);
+        Polyline<T> polyline(n);
+        for (size_t i = 1; i < n; ++i) {
+            polyline[i] = Point<T>(static_cast<T>(static_cast<double>(polyline[i - 1].x) + step(random)),
+                                   static_cast<T>(static_cast<double>(polyline[i - 1].y) + step(random)));
+        }
+        SegmentIndex<T> index(polyline);
+        check(index.size() == (n < 2 ? n : n - 1), name + ": segment count");
+
+        std::vector<Point<T>> queries;
+        for (int i = 0; i < 300; ++i) queries.push_back(Point<T>(static_cast<T>(place(random)), static_cast<T>(place(random))));
+        queries.push_back(polyline[n / 2]);
+        const size_t segments = n < 2 ? n : n - 1; //   -  
+        size_t nearestMismatches = 0;
+        for (const Point<T>& q : queries) {
+            std::vector<double> distances(segments);
+            for (size_t s = 0; s < segments; ++s) {
+                const Point<T>& first = polyline[s];
+                const Point<T>& last = polyline[std::min(s + 1, n - 1)];
+                double ax = static_cast<double>(first.x), ay = static_cast<double>(first.y);
+                double dx = static_cast<double>(last.x) - ax, dy = static_cast<double>(last.y) - ay;
+                double qx = static_cast<double>(q.x), qy = static_cast<double>(q.y);
+                double lengthSquared = dx * dx + dy * dy;
+                double t = lengthSquared > 0.0 ? std::clamp(((qx - ax) * dx + (qy - ay) * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+                distances[s] = std::hypot(ax + t * dx - qx, ay + t * dy - qy);
+            }
+            double best = *std::min_element(distances.begin(), distances.end());
+            auto found = index.nearestPoint(q);
+            //          
+            if (found.segment >= segments || !closeRelative(found.distance, best, 1e-12) ||
+                !closeRelative(distances[found.segment], best, 1e-12)) ++nearestMismatches;
+        }
+        check(nearestMismatches == 0, name + ": nearest point matches brute force");
+
+        std::vector<Bounds<T>> rects;
+        for (int i = 0; i < 100; ++i) {
+            Bounds<T> rect;
+            double x = place(random), y = place(random);
+            rect.expand(Point<T>(static_cast<T>(x), static_cast<T>(y)));
+            rect.expand(Point<T>(static_cast<T>(x + extent(random)), static_cast<T>(y + extent(random))));
+            rects.push_back(rect);
+        }
+        size_t rangeMismatches = 0;
+        for (const Bounds<T>& rect : rects) {
+            std::vector<size_t> expected;
+            for (size_t s = 0; s < segments; ++s) {
+                if (segmentTouchesRect(polyline[s], polyline[std::min(s + 1, n - 1)], rect)) expected.push_back(s);
+            }
+            if (index.segmentsInRect(rect) != expected) ++rangeMismatches;
+        }
+        check(rangeMismatches == 0, name + ": segments in rectangle match brute force");
+
+        std::vector<typename SegmentIndex<T>::Nearest> batch = index.nearestPoints(queries);
+        std::vector<std::vector<size_t>> rectBatch = index.segmentsInRects(rects);
+        bool sameBatch = batch.size() == queries.size() && rectBatch.size() == rects.size();
+        for (size_t i = 0; sameBatch && i < queries.size(); ++i) {
+            sameBatch = batch[i].segment == index.nearestPoint(queries[i]).segment && batch[i].distance == index.nearestPoint(queries[i]).distance;
+        }
+        for (size_t i = 0; sameBatch && i < rects.size(); ++i) sameBatch = rectBatch[i] == index.segmentsInRect(rects[i]);
+        check(sameBatch, name + ": batch queries match single queries");
+    }
+
+    Polyline<T> none(size_t(0));
+    SegmentIndex<T> empty(none);
+    bool thrown = false;
+    try {
+        empty.nearestPoint(Point<T>());
+    }
+    catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    Bounds<T> everything;
+    everything.expand(Point<T>(T(-1), T(-1)));
+    everything.expand(Point<T>(T(1), T(1)));
+    check(thrown && empty.empty() && empty.segmentsInRect(everything).empty(), "segment index<" + type + ">: empty polyline");
+}
+
+//   ,  ,  
+//    (   ).  
+//  ,     
+template<typename T>
+void testSweepIntersections(const std::string& type) {
+    using sweepKernels::widen;
+    Point<double> at;
+    const Point<double> o(0, 0), e(2, 0), n(0, 2), ne(2, 2), mid(1, 0), far(3, 0), up(1, 1);
+    check(sweepKernels::intersect(o, ne, e, n, at) && at.x == 1.0 && at.y == 1.0, "intersect<" + type + ">: crossing");
+    check(sweepKernels::intersect(o, e, mid, up, at) && at.x == 1.0 && at.y == 0.0, "intersect<" + type + ">: touching");
+    check(sweepKernels::intersect(o, e, mid, far, at), "intersect<" + type + ">: collinear overlap");
+    check(!sweepKernels::intersect(o, e, n, ne, at) && !sweepKernels::intersect(o, mid, Point<double>(1.5, 0), far, at),
+          "intersect<" + type + ">: parallel and collinear disjoint");
+
+    auto pairsOf = [](const std::vector<Intersection<T>>& found) {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (const Intersection<T>& hit : found) pairs.emplace_back(hit.first, hit.second);
+        return pairs;
+    };
+    auto samePoints = [](const std::vector<Intersection<T>>& a, const std::vector<Intersection<T>>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Intersection<T>& x, const Intersection<T>& y) {
+            return x.first == y.first && x.second == y.second && x.point.x == y.point.x && x.point.y == y.point.y;
+        });
+    };
+    std::mt19937_64 random(66);
+    const size_t savedThreshold = Polyline<T>::parallelThreshold;
+    for (int grid : {6, 1000}) {
+        for (size_t count : {size_t(3), size_t(30), size_t(400)}) {
+            const std::string name = "sweep<" + type + ">, grid " + std::to_string(grid) + ", n = " + std::to_string(count);
+            auto randomPolyline = [&](size_t size) {
+                Polyline<T> polyline(size);
+                for (Point<T>& point : polyline) point = Point<T>(static_cast<T>(random() % grid), static_cast<T>(random() % grid));
+                return polyline;
+            };
+            Polyline<T> a = randomPolyline(count);
+            a.push_back(a[0]); // :     
+            Polyline<T> b = randomPolyline(count / 2 + 2);
+
+            std::vector<std::pair<size_t, size_t>> expectedSelf;
+            const size_t last = a.size() - 2;
+            for (size_t i = 0; i < last; ++i) {
+                for (size_t j = i + 1; j <= last; ++j) {
+                    Point<double> p = widen(a[i]), q = widen(a[i + 1]), r = widen(a[j]), s = widen(a[j + 1]);
+                    if (!sweepKernels::intersect(p, q, r, s, at)) continue;
+                    bool next = j == i + 1;
+                    bool wrap = i == 0 && j == last && last > 1;
+                    if (next || wrap) {
+                        //   ,       
+                        Point<double> u = next ? p : q, v = next ? q : p, w = next ? s : r;
+                        if (sweepKernels::orientation(u, v, w) != 0 || (u.x - v.x) * (w.x - v.x) + (u.y - v.y) * (w.y - v.y) <= 0) continue;
+                    }
+                    expectedSelf.emplace_back(i, j);
+                }
+            }
+            std::vector<std::pair<size_t, size_t>> expectedCross;
+            for (size_t i = 0; i + 1 < a.size(); ++i) {
+                for (size_t j = 0; j + 1 < b.size(); ++j) {
+                    if (sweepKernels::intersect(widen(a[i]), widen(a[i + 1]), widen(b[j]), widen(b[j + 1]), at)) expectedCross.emplace_back(i, j);
+                }
+            }
+
+            std::vector<Intersection<T>> self = a.selfIntersections();
+            std::vector<Intersection<T>> cross = a.intersections(b);
+            check(pairsOf(self) == expectedSelf, name + ": self-intersections match brute force");
+            check(pairsOf(cross) == expectedCross, name + ": intersections match brute force");
+            Polyline<T>::parallelThreshold = 0;
+            check(samePoints(a.selfIntersections(parallel), self), name + ": parallel self-intersections");
+            check(samePoints(a.intersections(b, parallel), cross), name + ": parallel intersections");
+            Polyline<T>::parallelThreshold = savedThreshold;
+        }
+    }
+
+    //     :     
+    Polyline<T> walk(size_t(10000));
+    for (size_t i = 1; i < walk.size(); ++i) {
+        walk[i] = Point<T>(walk[i - 1].x + static_cast<T>(int(random() % 5) - 2), walk[i - 1].y + static_cast<T>(int(random() % 5) - 2));
+    }
+    size_t expectedCount = 0;
+    for (size_t i = 0; i + 2 < walk.size(); ++i) {
+        Bounds<T> box;
+        box.expand(walk[i]);
+        box.expand(walk[i + 1]);
+        for (size_t j = i + 2; j + 1 < walk.size(); ++j) {
+            if (walk[j].x < box.min.x && walk[j + 1].x < box.min.x) continue;
+            if (walk[j].x > box.max.x && walk[j + 1].x > box.max.x) continue;
+            if (sweepKernels::intersect(widen(walk[i]), widen(walk[i + 1]), widen(walk[j]), widen(walk[j + 1]), at)) ++expectedCount;
+        }
+    }
+    std::vector<Intersection<T>> walkSelf = walk.selfIntersections();
+    size_t adjacentOverlaps = static_cast<size_t>(std::count_if(walkSelf.begin(), walkSelf.end(), [](const Intersection<T>& hit) {
+        return hit.second == hit.first + 1;
+    }));
+    check(walkSelf.size() - adjacentOverlaps == expectedCount, "sweep<" + type + ">, walk: non-adjacent pairs match brute force");
+    Polyline<T>::parallelThreshold = 0;
+    check(samePoints(walk.selfIntersections(parallel), walkSelf), "sweep<" + type + ">, walk: parallel blocks");
+    Polyline<T>::parallelThreshold = savedThreshold;
+}
+
+} // namespace
+
+int main() {
+    testConcatWithTemporaryPoint();
+    testRopeChunksStayLarge();
+    testPointAtOutOfRangeAndNan();
+    testConcurrentPointAt();
+    testConcurrentBounds();
+    testConcurrentDeduplicatorFind();
+    testEmptyCollection();
+    testParallelExceptions();
+    testTextLongTokens();
+    testMaterialize();
+    testSimdLength<double>("double", 1e-12);
+    testSimdLength<float>("float", 1e-5);
+    testParallelLength();
+    testPhilox();
+    testBinaryRoundTrip<double>("double");
+    testBinaryRoundTrip<float>("float");
+    testTextRoundTrip<double>("double");
+    testTextRoundTrip<float>("float");
+    testSmallBuffer();
+    testCopyOnWrite();
+    testRopeEdits();
+    testDeduplicatorNearDuplicates();
+    testAffineTransform<double>("double", 1e-14);
+    testAffineTransform<float>("float", 1e-6);
+    testBoundsAndHull<double>("double");
+    testBoundsAndHull<float>("float");
+    testSegmentIndex<double>("double");
+    testSegmentIndex<float>("float");
+    testSweepIntersections<double>("double");
+    testSweepIntersections<float>("float");
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "All tests passed\n";
+    return 0;
+}